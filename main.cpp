@@ -1,5 +1,9 @@
 #include "src/RenderEngine/RenderEngine.hpp"
 #include "src/RenderEngine/Octree.hpp"
+#include "src/RenderEngine/CpuRenderer.hpp"
+
+#include <charconv>
+#include <string_view>
 
 #define FREE_CAMERA
 
@@ -7,6 +11,13 @@
 #define CAMERA_ROTATE_SPEED 0.01f
 #define CAMERA_ZOOM_SPEED 15.0f
 
+#define HEADLESS_IMAGE_WIDTH 1280
+#define HEADLESS_IMAGE_HEIGHT 720
+#define HEADLESS_OCTREE_DEPTH 8
+// Largest headless image side, keeps the color buffer within a few GB
+#define HEADLESS_MAX_IMAGE_SIZE 16384
+#define HEADLESS_USAGE "Usage: Renderer --render <model.obj> <image.png|ppm> [width] [height] [octree depth]"
+
 glm::vec2 previousMousePos = {-1.0f, -1.0f};
 
 RenderEngine* renderEngine;
@@ -83,7 +94,77 @@ void processInput(Window* window) {
     #endif
 }
 
-int main() {
+bool parseArgument(int argc, char** argv, int index, uint32_t minValue, uint32_t maxValue, uint32_t& value) {
+    // Missing arguments keep their default, anything else has to be a whole number in range
+    if (index >= argc) return true;
+    std::string_view text = argv[index];
+    uint32_t parsed;
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), parsed);
+    if (error != std::errc() || end != text.data() + text.size() || parsed < minValue || parsed > maxValue) {
+        spdlog::error("Invalid argument \"" + std::string(text) + "\", expected a number from " + std::to_string(minValue) + " to " + std::to_string(maxValue) + ".");
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+int renderHeadless(std::string objPath, std::string imagePath, uint32_t width, uint32_t height, uint32_t octreeDepth) {
+    // Voxelize and ray cast on the CPU only, no window or Vulkan device is created
+    Mesh* mesh = Utils::loadOBJFile(objPath, "assets/materials");
+    Volume volume = Voxelizer::voxelizeMesh(mesh);
+    delete mesh;
+
+    Octree* octree = new Octree();
+    octree->buildMorton(volume.voxels, octreeDepth);
+    if (octree->isEmpty()) {
+        spdlog::error("Nothing to render in " + objPath);
+        delete octree;
+        return 1;
+    }
+
+    // Look at the volume from above one corner. Voxels are drawn mirrored in y,
+    // so the camera aims at the mirrored center like it would in the window
+    AABB bounds = octree->getRoot()->getVoxel().aabb;
+    glm::vec3 target = glm::vec3(bounds.center.x, -bounds.center.y, bounds.center.z);
+    glm::vec3 position = target + glm::vec3(-0.6f, 0.5f, -0.8f) * glm::length(bounds.max - bounds.min);
+    glm::vec3 front = glm::normalize(target - position);
+
+    Camera* camera = new Camera();
+    camera->setPosition(position);
+    camera->setYaw(glm::atan(front.x, front.z));
+    camera->setPitch(glm::asin(front.y));
+    camera->setFOV(60.0f);
+    camera->setNearPlane(0.1f);
+    camera->setFarPlane(1000.0f);
+    camera->setAspectRatio((float)width / (float)height);
+    camera->generateViewMatrix();
+    camera->generateProjectionMatrix();
+
+    CpuRenderer* renderer = new CpuRenderer(width, height);
+    bool saved = renderer->renderToFile(camera, octree, imagePath);
+
+    delete renderer;
+    delete camera;
+    delete octree;
+    return saved ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    // Renderer --render <model.obj> <image.png|ppm> [width] [height] [octree depth]
+    if (argc >= 2 && std::string(argv[1]) == "--render") {
+        uint32_t width = HEADLESS_IMAGE_WIDTH;
+        uint32_t height = HEADLESS_IMAGE_HEIGHT;
+        uint32_t octreeDepth = HEADLESS_OCTREE_DEPTH;
+        if (argc < 4 || argc > 7 ||
+            !parseArgument(argc, argv, 4, 1, HEADLESS_MAX_IMAGE_SIZE, width) ||
+            !parseArgument(argc, argv, 5, 1, HEADLESS_MAX_IMAGE_SIZE, height) ||
+            !parseArgument(argc, argv, 6, 1, MORTON_MAX_LEVELS + 1, octreeDepth)) {
+            spdlog::error(HEADLESS_USAGE);
+            return 1;
+        }
+        return renderHeadless(argv[2], argv[3], width, height, octreeDepth);
+    }
+
     renderEngine = new RenderEngine();
 
     while (!renderEngine->window->shouldClose()) {
@@ -0,0 +1,137 @@
+#include "CpuRenderer.hpp"
+
+CpuRenderer::CpuRenderer(uint32_t width, uint32_t height, uint32_t threadCount) {
+    this->width = width;
+    this->height = height;
+    this->pool = new ThreadPool(std::max(threadCount, 1u));
+    this->lastRenderStats = {0.0, 0, 0};
+
+    #ifndef NDEBUG
+        spdlog::info("New CPU renderer successfully created.");
+    #endif
+}
+
+CpuRenderer::~CpuRenderer() {
+    delete pool;
+}
+
+ImageData CpuRenderer::render(Camera* camera, Octree* octree) {
+    ImageData image;
+    image.name = "cpu_render";
+    image.loaded = true;
+    image.width = width;
+    image.height = height;
+    image.depth = 1;
+    image.channels = 3;
+    image.data = std::vector<uint8_t>((size_t)width * height * 3, 0);
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    glm::mat4 viewProjection = camera->getProjectionMatrix() * camera->getViewMatrix();
+    glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+    glm::vec3 viewDirection = camera->getFrontVector();
+
+    // One task per tile, the pool's work stealing evens out tiles with more voxels
+    uint32_t tilesX = (width + CPU_RENDERER_TILE_SIZE - 1) / CPU_RENDERER_TILE_SIZE;
+    uint32_t tilesY = (height + CPU_RENDERER_TILE_SIZE - 1) / CPU_RENDERER_TILE_SIZE;
+    std::vector<size_t> tileHitCounts((size_t)tilesX * tilesY, 0);
+    for (uint32_t tileY = 0; tileY < tilesY; tileY++) {
+        for (uint32_t tileX = 0; tileX < tilesX; tileX++) {
+            size_t& hitCount = tileHitCounts[tileY * tilesX + tileX];
+            pool->submit([this, octree, viewProjection, inverseViewProjection, viewDirection, tileX, tileY, &image, &hitCount]() {
+                renderTile(octree, viewProjection, inverseViewProjection, viewDirection, tileX, tileY, image.data, hitCount);
+            });
+        }
+    }
+    pool->wait();
+
+    lastRenderStats.renderTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    lastRenderStats.rayCount = (size_t)width * height;
+    lastRenderStats.hitCount = 0;
+    for (size_t hitCount : tileHitCounts)
+        lastRenderStats.hitCount += hitCount;
+
+    return image;
+}
+
+bool CpuRenderer::renderToFile(Camera* camera, Octree* octree, std::string imagePath) {
+    ImageData image = render(camera, octree);
+    spdlog::info("CPU render of " + std::to_string(width) + "x" + std::to_string(height) + " took " + std::to_string(lastRenderStats.renderTime) + " ms on " + std::to_string(pool->getThreadCount()) + " threads (" + std::to_string(lastRenderStats.rayCount / lastRenderStats.renderTime / 1e3) + " Mrays/s).");
+    return Utils::saveImageFile(imagePath, image);
+}
+
+CpuRenderStats CpuRenderer::getLastRenderStats() {
+    return lastRenderStats;
+}
+
+void CpuRenderer::renderTile(Octree* octree, glm::mat4 viewProjection, glm::mat4 inverseViewProjection, glm::vec3 viewDirection, uint32_t tileX, uint32_t tileY, std::vector<uint8_t>& pixels, size_t& hitCount) {
+    uint32_t startX = tileX * CPU_RENDERER_TILE_SIZE;
+    uint32_t startY = tileY * CPU_RENDERER_TILE_SIZE;
+    uint32_t endX = std::min(startX + CPU_RENDERER_TILE_SIZE, width);
+    uint32_t endY = std::min(startY + CPU_RENDERER_TILE_SIZE, height);
+
+    Ray rays[CPU_RENDERER_TILE_SIZE * CPU_RENDERER_TILE_SIZE];
+    Hit hits[CPU_RENDERER_TILE_SIZE * CPU_RENDERER_TILE_SIZE];
+    glm::vec3 nearPoints[CPU_RENDERER_TILE_SIZE * CPU_RENDERER_TILE_SIZE];
+
+    uint32_t rayCount = 0;
+    for (uint32_t y = startY; y < endY; y++) {
+        for (uint32_t x = startX; x < endX; x++) {
+            // Unproject the pixel center on the near and far planes
+            glm::vec2 ndc = glm::vec2((x + 0.5f) / width, (y + 0.5f) / height) * 2.0f - 1.0f;
+            glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndc.x, ndc.y, -1.0f, 1.0f);
+            glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndc.x, ndc.y, 1.0f, 1.0f);
+            glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+            glm::vec3 segment = glm::vec3(farPoint) / farPoint.w - origin;
+
+            // The octree lives in the unmirrored voxel space
+            nearPoints[rayCount] = origin;
+            rays[rayCount] = {
+                .origin = glm::vec3(origin.x, -origin.y, origin.z),
+                .direction = glm::normalize(glm::vec3(segment.x, -segment.y, segment.z)),
+                .tMax = glm::length(segment)
+            };
+            rayCount++;
+        }
+    }
+
+    octree->raycastPackets(std::span<const Ray>(rays, rayCount), std::span<Hit>(hits, rayCount));
+
+    uint32_t rayIndex = 0;
+    for (uint32_t y = startY; y < endY; y++) {
+        for (uint32_t x = startX; x < endX; x++) {
+            const Ray& ray = rays[rayIndex];
+            const Hit& hit = hits[rayIndex];
+
+            // Same sky color the Vulkan render pass clears to
+            glm::vec3 color = glm::vec3(135.0f, 206.0f, 235.0f) / 255.0f;
+            if (hit.leaf != nullptr) {
+                glm::vec3 direction = glm::vec3(ray.direction.x, -ray.direction.y, ray.direction.z);
+                glm::vec4 clipPosition = viewProjection * glm::vec4(nearPoints[rayIndex] + direction * hit.t, 1.0f);
+                color = shadeVoxel(hit.leaf->getVoxel(), clipPosition, viewDirection);
+                hitCount++;
+            }
+
+            uint8_t* pixel = &pixels[((size_t)y * width + x) * 3];
+            for (uint32_t channel = 0; channel < 3; channel++)
+                pixel[channel] = (uint8_t)(glm::clamp(color[channel], 0.0f, 1.0f) * 255.0f + 0.5f);
+            rayIndex++;
+        }
+    }
+}
+
+glm::vec3 CpuRenderer::shadeVoxel(Voxel voxel, glm::vec4 clipPosition, glm::vec3 viewDirection) {
+    // voxel.frag, including its light placed at the view direction and the
+    // clip space fragment position
+    glm::vec3 lightColor = glm::vec3(0.025f);
+    glm::vec3 lightPosition = viewDirection;
+    glm::vec3 lightDirection = glm::normalize(lightPosition - glm::vec3(clipPosition));
+
+    float ambientStrength = 0.01f;
+    glm::vec3 ambientLight = ambientStrength * lightColor;
+
+    float diffuse = std::max(glm::dot(voxel.normal, lightDirection), 0.0f);
+    glm::vec3 diffuseLight = diffuse * lightColor;
+
+    return (ambientLight + diffuseLight) * unpackVoxelColor(voxel.renderData);
+}
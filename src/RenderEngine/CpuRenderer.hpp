@@ -0,0 +1,48 @@
+#ifndef _CPU_RENDERER_HPP_
+#define _CPU_RENDERER_HPP_
+
+// Square tiles handed to the worker threads, rows of a tile are traced as ray packets
+#define CPU_RENDERER_TILE_SIZE 16
+
+#include <stdint.h>
+#include <vector>
+#include <span>
+#include <chrono>
+#include <glm/glm.hpp>
+
+#include "Camera.hpp"
+#include "Octree.hpp"
+#include "ThreadPool.hpp"
+#include "Utils.hpp"
+
+struct CpuRenderStats {
+    double renderTime;
+    size_t rayCount;
+    size_t hitCount;
+};
+
+/*
+    Headless voxel renderer. Rays are cast through the octree leaves instead of
+    rasterizing the voxel cubes, and every hit is shaded like voxel.frag.
+
+    The image matches the Vulkan window for the same camera: rows go top to
+    bottom in NDC y, and voxels are mirrored in y as voxel.geom does.
+*/
+class CpuRenderer {
+public:
+    CpuRenderer(uint32_t width, uint32_t height, uint32_t threadCount = ThreadPool::getHardwareThreadCount());
+    ~CpuRenderer();
+
+    ImageData render(Camera* camera, Octree* octree);
+    bool renderToFile(Camera* camera, Octree* octree, std::string imagePath);
+    CpuRenderStats getLastRenderStats();
+private:
+    uint32_t width, height;
+    ThreadPool* pool;
+    CpuRenderStats lastRenderStats;
+
+    void renderTile(Octree* octree, glm::mat4 viewProjection, glm::mat4 inverseViewProjection, glm::vec3 viewDirection, uint32_t tileX, uint32_t tileY, std::vector<uint8_t>& pixels, size_t& hitCount);
+    static glm::vec3 shadeVoxel(Voxel voxel, glm::vec4 clipPosition, glm::vec3 viewDirection);
+};
+
+#endif
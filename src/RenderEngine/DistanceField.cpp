@@ -0,0 +1,192 @@
+#include "DistanceField.hpp"
+
+DistanceField::DistanceField(glm::ivec3 minCell, glm::ivec3 size) {
+    this->minCell = minCell;
+    this->size = glm::max(size, glm::ivec3(1));
+    this->brickGridSize = (this->size + DISTANCE_FIELD_BRICK_SIZE - 1) / DISTANCE_FIELD_BRICK_SIZE;
+
+    size_t brickCount = (size_t)brickGridSize.x * brickGridSize.y * brickGridSize.z;
+    distances = std::vector<float>(brickCount * DISTANCE_FIELD_BRICK_CELLS, std::numeric_limits<float>::max());
+}
+
+float DistanceField::getDistance(glm::ivec3 cell) {
+    glm::ivec3 local = cell - minCell;
+    if (glm::any(glm::lessThan(local, glm::ivec3(0))) || glm::any(glm::greaterThan(local, size - 1)))
+        return std::numeric_limits<float>::max();
+    return distances[getLocalOffset(local)];
+}
+
+void DistanceField::setDistance(glm::ivec3 cell, float distance) {
+    glm::ivec3 local = cell - minCell;
+    if (glm::any(glm::lessThan(local, glm::ivec3(0))) || glm::any(glm::greaterThan(local, size - 1)))
+        return;
+    distances[getLocalOffset(local)] = distance;
+}
+
+float DistanceField::sampleDistance(glm::vec3 position) {
+    // Trilinear between the cell centers, clamped to the grid
+    glm::vec3 local = glm::clamp(position - glm::vec3(minCell) - 0.5f, glm::vec3(0.0f), glm::vec3(size - 1));
+    glm::ivec3 base = glm::min(glm::ivec3(glm::floor(local)), glm::max(size - 2, glm::ivec3(0)));
+    glm::vec3 weight = local - glm::vec3(base);
+    glm::ivec3 last = size - 1;
+
+    float corners[8];
+    for (uint32_t corner = 0; corner < 8; corner++) {
+        glm::ivec3 offset = glm::ivec3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1);
+        corners[corner] = distances[getLocalOffset(glm::min(base + offset, last))];
+    }
+
+    float x00 = glm::mix(corners[0], corners[1], weight.x);
+    float x10 = glm::mix(corners[2], corners[3], weight.x);
+    float x01 = glm::mix(corners[4], corners[5], weight.x);
+    float x11 = glm::mix(corners[6], corners[7], weight.x);
+    return glm::mix(glm::mix(x00, x10, weight.y), glm::mix(x01, x11, weight.y), weight.z);
+}
+
+glm::vec3 DistanceField::getGradient(glm::vec3 position) {
+    // Central differences one cell apart, normalized into a surface normal
+    glm::vec3 gradient = glm::vec3(
+        sampleDistance(position + glm::vec3(0.5f, 0.0f, 0.0f)) - sampleDistance(position - glm::vec3(0.5f, 0.0f, 0.0f)),
+        sampleDistance(position + glm::vec3(0.0f, 0.5f, 0.0f)) - sampleDistance(position - glm::vec3(0.0f, 0.5f, 0.0f)),
+        sampleDistance(position + glm::vec3(0.0f, 0.0f, 0.5f)) - sampleDistance(position - glm::vec3(0.0f, 0.0f, 0.5f))
+    );
+    return glm::length(gradient) > 0.0f ? glm::normalize(gradient) : gradient;
+}
+
+void DistanceField::sweep(float fixedDistance, ThreadPool* pool) {
+    // Fast sweeping: cells further than fixedDistance from the surface take the
+    // Eikonal solution of their neighbors, in the 8 diagonal orders. Bricks on one
+    // plane x + y + z = level share no face, so they are swept in parallel, split by
+    // y, while the cells inside a brick go in raster order. Upwind bricks are always
+    // done before, so every order stays a Gauss-Seidel sweep. Distances are read as
+    // magnitudes, fixed cells keep their sign
+    int levelCount = brickGridSize.x + brickGridSize.y + brickGridSize.z - 2;
+    int rowsPerTask = std::max(1, DISTANCE_FIELD_SWEEP_TASK_BRICKS / std::max(brickGridSize.x, brickGridSize.z));
+    for (uint32_t order = 0; order < 8; order++) {
+        glm::ivec3 direction = glm::ivec3(order & 1 ? -1 : 1, order & 2 ? -1 : 1, order & 4 ? -1 : 1);
+        for (int level = 0; level < levelCount; level++) {
+            int firstY = std::max(0, level - (brickGridSize.x - 1) - (brickGridSize.z - 1));
+            int lastY = std::min(brickGridSize.y - 1, level);
+            if (lastY - firstY < rowsPerTask) {
+                sweepPlane(direction, level, firstY, lastY, fixedDistance);
+                continue;
+            }
+
+            for (int y = firstY; y <= lastY; y += rowsPerTask)
+                pool->submit([this, direction, level, y, lastY, rowsPerTask, fixedDistance]() {
+                    sweepPlane(direction, level, y, std::min(y + rowsPerTask - 1, lastY), fixedDistance);
+                });
+            pool->wait();
+        }
+    }
+}
+
+glm::ivec3 DistanceField::getMinCell() {
+    return minCell;
+}
+
+glm::ivec3 DistanceField::getSize() {
+    return size;
+}
+
+size_t DistanceField::getCellCount() {
+    return (size_t)size.x * size.y * size.z;
+}
+
+size_t DistanceField::getBrickCount() {
+    return distances.size() / DISTANCE_FIELD_BRICK_CELLS;
+}
+
+size_t DistanceField::getMemoryUsage() {
+    return distances.capacity() * sizeof(float);
+}
+
+float* DistanceField::getBrickData() {
+    // getBrickCount() bricks of DISTANCE_FIELD_BRICK_CELLS values, cells past the size included
+    return distances.data();
+}
+
+size_t DistanceField::getLocalOffset(glm::ivec3 local) {
+    uint32_t mask = DISTANCE_FIELD_BRICK_SIZE - 1;
+    size_t brick = ((size_t)(local.y >> DISTANCE_FIELD_BRICK_BITS) * brickGridSize.z + (local.z >> DISTANCE_FIELD_BRICK_BITS)) * brickGridSize.x + (local.x >> DISTANCE_FIELD_BRICK_BITS);
+    uint32_t cell = ((local.y & mask) << (2 * DISTANCE_FIELD_BRICK_BITS)) | ((local.z & mask) << DISTANCE_FIELD_BRICK_BITS) | (local.x & mask);
+    return brick * DISTANCE_FIELD_BRICK_CELLS + cell;
+}
+
+void DistanceField::sweepPlane(glm::ivec3 direction, int level, int firstY, int lastY, float fixedDistance) {
+    // Plane coordinates count from the corner the sweep starts at
+    for (int planeY = firstY; planeY <= lastY; planeY++) {
+        int remaining = level - planeY;
+        int firstZ = std::max(0, remaining - (brickGridSize.x - 1));
+        int lastZ = std::min(brickGridSize.z - 1, remaining);
+        for (int planeZ = firstZ; planeZ <= lastZ; planeZ++) {
+            int planeX = remaining - planeZ;
+            glm::ivec3 brick = glm::ivec3(
+                direction.x > 0 ? planeX : brickGridSize.x - 1 - planeX,
+                direction.y > 0 ? planeY : brickGridSize.y - 1 - planeY,
+                direction.z > 0 ? planeZ : brickGridSize.z - 1 - planeZ
+            );
+            sweepBrick(direction, brick, fixedDistance);
+        }
+    }
+}
+
+void DistanceField::sweepBrick(glm::ivec3 direction, glm::ivec3 brick, float fixedDistance) {
+    const float farDistance = std::numeric_limits<float>::max();
+    const int mask = DISTANCE_FIELD_BRICK_SIZE - 1;
+
+    // Offset steps to the previous and next cell on every axis, inside the brick and across into the next one
+    const size_t innerSteps[3] = {1, DISTANCE_FIELD_BRICK_SIZE * DISTANCE_FIELD_BRICK_SIZE, DISTANCE_FIELD_BRICK_SIZE};
+    const size_t brickSteps[3] = {
+        DISTANCE_FIELD_BRICK_CELLS,
+        (size_t)brickGridSize.x * brickGridSize.z * DISTANCE_FIELD_BRICK_CELLS,
+        (size_t)brickGridSize.x * DISTANCE_FIELD_BRICK_CELLS
+    };
+    auto getNeighborMagnitude = [&](size_t offset, glm::ivec3 local, int axis, int step) -> float {
+        int coordinate = local[axis] + step;
+        if (coordinate < 0 || coordinate >= size[axis]) return farDistance;
+
+        bool crossesBrick = step < 0 ? (local[axis] & mask) == 0 : (local[axis] & mask) == mask;
+        size_t delta = crossesBrick ? brickSteps[axis] - mask * innerSteps[axis] : innerSteps[axis];
+        return std::abs(distances[step < 0 ? offset - delta : offset + delta]);
+    };
+
+    glm::ivec3 origin = brick * DISTANCE_FIELD_BRICK_SIZE;
+    for (int i = 0; i < DISTANCE_FIELD_BRICK_SIZE; i++) {
+        for (int j = 0; j < DISTANCE_FIELD_BRICK_SIZE; j++) {
+            for (int k = 0; k < DISTANCE_FIELD_BRICK_SIZE; k++) {
+                glm::ivec3 local = origin + glm::ivec3(
+                    direction.x > 0 ? k : mask - k,
+                    direction.y > 0 ? i : mask - i,
+                    direction.z > 0 ? j : mask - j
+                );
+                if (local.x >= size.x || local.y >= size.y || local.z >= size.z) continue;
+
+                size_t offset = getLocalOffset(local);
+                float& distance = distances[offset];
+                if (std::abs(distance) <= fixedDistance) continue;
+
+                // Smallest neighbor per axis, sorted, then the Godunov upwind solution on unit cells
+                float a = std::min(getNeighborMagnitude(offset, local, 0, -1), getNeighborMagnitude(offset, local, 0, 1));
+                float b = std::min(getNeighborMagnitude(offset, local, 1, -1), getNeighborMagnitude(offset, local, 1, 1));
+                float c = std::min(getNeighborMagnitude(offset, local, 2, -1), getNeighborMagnitude(offset, local, 2, 1));
+                if (a > b) std::swap(a, b);
+                if (b > c) std::swap(b, c);
+                if (a > b) std::swap(a, b);
+                if (a == farDistance) continue;
+
+                float solution = a + 1.0f;
+                if (solution > b) {
+                    solution = 0.5f * (a + b + std::sqrt(2.0f - (a - b) * (a - b)));
+                    if (solution > c) {
+                        float sum = a + b + c;
+                        solution = (sum + std::sqrt(std::max(0.0f, sum * sum - 3.0f * (a * a + b * b + c * c - 1.0f)))) / 3.0f;
+                    }
+                }
+
+                // Cells not fixed get their sign once the field is swept
+                distance = std::min(std::abs(distance), solution);
+            }
+        }
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef _DISTANCE_FIELD_HPP_
+#define _DISTANCE_FIELD_HPP_
+
+#include <stdint.h>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <glm/glm.hpp>
+
+#include "ThreadPool.hpp"
+
+// Distances are stored in 8x8x8 bricks, cells y, z, x inside a brick and bricks y, z, x in the grid
+#define DISTANCE_FIELD_BRICK_BITS 3
+#define DISTANCE_FIELD_BRICK_SIZE (1 << DISTANCE_FIELD_BRICK_BITS)
+#define DISTANCE_FIELD_BRICK_CELLS (DISTANCE_FIELD_BRICK_SIZE * DISTANCE_FIELD_BRICK_SIZE * DISTANCE_FIELD_BRICK_SIZE)
+// Bricks of a sweep plane given to one task
+#define DISTANCE_FIELD_SWEEP_TASK_BRICKS 64
+
+// Signed distances, in cells, sampled at the centers of the unit cells of
+// [minCell, minCell + size). Negative inside. Cells nobody wrote hold
+// std::numeric_limits<float>::max().
+class DistanceField {
+public:
+    DistanceField(glm::ivec3 minCell, glm::ivec3 size);
+
+    float getDistance(glm::ivec3 cell);
+    void setDistance(glm::ivec3 cell, float distance);
+    float sampleDistance(glm::vec3 position);
+    glm::vec3 getGradient(glm::vec3 position);
+    void sweep(float fixedDistance, ThreadPool* pool);
+    glm::ivec3 getMinCell();
+    glm::ivec3 getSize();
+    size_t getCellCount();
+    size_t getBrickCount();
+    size_t getMemoryUsage();
+    float* getBrickData();
+private:
+    glm::ivec3 minCell, size, brickGridSize;
+    std::vector<float> distances;
+
+    size_t getLocalOffset(glm::ivec3 local);
+    void sweepPlane(glm::ivec3 direction, int level, int firstY, int lastY, float fixedDistance);
+    void sweepBrick(glm::ivec3 direction, glm::ivec3 brick, float fixedDistance);
+};
+
+#endif
@@ -4,3 +4,165 @@ bool isPointInsideAABB(AABB aabb, glm::vec3 point) {
     return (point.x >= aabb.min.x && point.y >= aabb.min.y && point.z >= aabb.min.z) &&
            (point.x <= aabb.max.x && point.y <= aabb.max.y && point.z <= aabb.max.z);
 }
+
+bool isTriangleIntersectingAABB(glm::vec3 v0, glm::vec3 v1, glm::vec3 v2, AABB aabb) {
+    // Separating axis test (Akenine-Moller). Touching counts as overlapping
+    glm::vec3 center = (aabb.min + aabb.max) / 2.0f;
+    glm::vec3 halfSize = (aabb.max - aabb.min) / 2.0f;
+    v0 -= center;
+    v1 -= center;
+    v2 -= center;
+
+    // Box face normals, the triangle bounds against the box
+    for (uint32_t axis = 0; axis < 3; axis++) {
+        float triangleMin = std::min(v0[axis], std::min(v1[axis], v2[axis]));
+        float triangleMax = std::max(v0[axis], std::max(v1[axis], v2[axis]));
+        if (triangleMin > halfSize[axis] || triangleMax < -halfSize[axis])
+            return false;
+    }
+
+    // Triangle plane against the box
+    glm::vec3 edges[3] = {v1 - v0, v2 - v1, v0 - v2};
+    glm::vec3 normal = glm::cross(edges[0], edges[1]);
+    float planeDistance = glm::dot(normal, v0);
+    float boxRadius = glm::dot(halfSize, glm::abs(normal));
+    if (std::abs(planeDistance) > boxRadius)
+        return false;
+
+    // Cross products of the box axes with the triangle edges
+    for (uint32_t edge = 0; edge < 3; edge++) {
+        for (uint32_t axis = 0; axis < 3; axis++) {
+            glm::vec3 boxAxis = glm::vec3(0.0f);
+            boxAxis[axis] = 1.0f;
+            glm::vec3 separatingAxis = glm::cross(boxAxis, edges[edge]);
+
+            float p0 = glm::dot(v0, separatingAxis);
+            float p1 = glm::dot(v1, separatingAxis);
+            float p2 = glm::dot(v2, separatingAxis);
+            float radius = glm::dot(halfSize, glm::abs(separatingAxis));
+            if (std::min(p0, std::min(p1, p2)) > radius || std::max(p0, std::max(p1, p2)) < -radius)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+glm::vec3 getClosestTrianglePoint(glm::vec3 point, glm::vec3 v0, glm::vec3 v1, glm::vec3 v2) {
+    // Voronoi regions of the vertices, then the edges, then the face (Ericson)
+    glm::vec3 edge0 = v1 - v0;
+    glm::vec3 edge1 = v2 - v0;
+    glm::vec3 offset0 = point - v0;
+    float d1 = glm::dot(edge0, offset0);
+    float d2 = glm::dot(edge1, offset0);
+    if (d1 <= 0.0f && d2 <= 0.0f) return v0;
+
+    glm::vec3 offset1 = point - v1;
+    float d3 = glm::dot(edge0, offset1);
+    float d4 = glm::dot(edge1, offset1);
+    if (d3 >= 0.0f && d4 <= d3) return v1;
+
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+        return v0 + edge0 * (d1 / (d1 - d3));
+
+    glm::vec3 offset2 = point - v2;
+    float d5 = glm::dot(edge0, offset2);
+    float d6 = glm::dot(edge1, offset2);
+    if (d6 >= 0.0f && d5 <= d6) return v2;
+
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+        return v0 + edge1 * (d2 / (d2 - d6));
+
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+        return v1 + (v2 - v1) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+    float denominator = 1.0f / (va + vb + vc);
+    return v0 + edge0 * (vb * denominator) + edge1 * (vc * denominator);
+}
+
+uint32_t getAABBPointOctant(AABB aabb, glm::vec3 point) {
+    glm::vec3 split = aabb.min + (aabb.max - aabb.min) / 2.0f;
+    return (point.x >= split.x ? 1 : 0) |
+           (point.z >= split.z ? 2 : 0) |
+           (point.y >= split.y ? 4 : 0);
+}
+
+uint32_t getAABBChildOctant(AABB parentAABB, AABB childAABB) {
+    return (childAABB.center.x > parentAABB.center.x ? 1 : 0) |
+           (childAABB.center.z > parentAABB.center.z ? 2 : 0) |
+           (childAABB.center.y > parentAABB.center.y ? 4 : 0);
+}
+
+AABB getAABBChild(AABB parentAABB, uint32_t octant) {
+    glm::vec3 halfSize = (parentAABB.max - parentAABB.min) / 2.0f;
+
+    AABB childAABB;
+    childAABB.min = parentAABB.min + glm::vec3(
+        (octant & 1) ? halfSize.x : 0.0f,
+        (octant & 4) ? halfSize.y : 0.0f,
+        (octant & 2) ? halfSize.z : 0.0f
+    );
+    childAABB.max = childAABB.min + halfSize;
+    childAABB.center = (childAABB.min + childAABB.max) / 2.0f;
+    return childAABB;
+}
+
+AABB getVoxelBounds(const std::vector<Voxel>& voxels) {
+    AABB bounds;
+    bounds.min = glm::vec3(std::numeric_limits<float>::max());
+    bounds.max = glm::vec3(std::numeric_limits<float>::lowest());
+    for (const Voxel& voxel : voxels) {
+        bounds.min = glm::min(bounds.min, voxel.position);
+        bounds.max = glm::max(bounds.max, voxel.position);
+    }
+
+    bounds.min -= LENGTH_EPSILON;
+    bounds.max += LENGTH_EPSILON;
+    bounds.center = (bounds.min + bounds.max) / 2.0f;
+    return bounds;
+}
+
+uint32_t packVoxelColor(glm::vec3 color) {
+    // | MaterialID | R | G | B |, material left at 0
+    color = glm::clamp(color, 0.0f, 1.0f);
+    uint32_t renderData = 0;
+    renderData += (uint8_t)(color.z * 255.0f);
+    renderData += (uint8_t)(color.y * 255.0f) << 8;
+    renderData += (uint8_t)(color.x * 255.0f) << 16;
+    return renderData;
+}
+
+glm::vec3 unpackVoxelColor(uint32_t renderData) {
+    return glm::vec3((renderData >> 16) & 0xFF, (renderData >> 8) & 0xFF, renderData & 0xFF) / 255.0f;
+}
+
+uint16_t packOctahedralNormal(glm::vec3 normal) {
+    // Project onto the octahedron, folding the lower half over the diagonals
+    float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (length == 0.0f) return 0;
+    glm::vec2 octahedral = glm::vec2(normal.x, normal.y) / length;
+    if (normal.z < 0.0f)
+        octahedral = (1.0f - glm::abs(glm::vec2(octahedral.y, octahedral.x))) * glm::vec2(octahedral.x >= 0.0f ? 1.0f : -1.0f, octahedral.y >= 0.0f ? 1.0f : -1.0f);
+
+    int8_t x = (int8_t)std::round(std::clamp(octahedral.x, -1.0f, 1.0f) * 127.0f);
+    int8_t y = (int8_t)std::round(std::clamp(octahedral.y, -1.0f, 1.0f) * 127.0f);
+    return (uint16_t)((uint8_t)x | ((uint8_t)y << 8));
+}
+
+glm::vec3 unpackOctahedralNormal(uint16_t packedNormal) {
+    glm::vec2 octahedral = glm::vec2((int8_t)(packedNormal & 0xFF), (int8_t)(packedNormal >> 8)) / 127.0f;
+    glm::vec3 normal = glm::vec3(octahedral.x, octahedral.y, 1.0f - std::abs(octahedral.x) - std::abs(octahedral.y));
+    float fold = std::max(-normal.z, 0.0f);
+    normal.x += normal.x >= 0.0f ? -fold : fold;
+    normal.y += normal.y >= 0.0f ? -fold : fold;
+    return glm::length(normal) > 0.0f ? glm::normalize(normal) : normal;
+}
+
+glm::uvec3 getVoxelCell(AABB bounds, uint32_t depth, glm::vec3 position) {
+    float cellCount = (float)(1u << (std::max(depth, 1u) - 1));
+    glm::vec3 cell = glm::floor((position - bounds.min) / (bounds.max - bounds.min) * cellCount);
+    return glm::uvec3(glm::clamp(cell, glm::vec3(0.0f), glm::vec3(cellCount - 1.0f)));
+}
@@ -1,6 +1,12 @@
 #ifndef _GEOMETRY_H_
 #define _GEOMETRY_H_
 
+#define LENGTH_EPSILON 1e-3
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <limits>
 #include <glm/glm.hpp>
 
 struct AABB {
@@ -9,6 +15,12 @@ struct AABB {
     glm::vec3 center;
 };
 
+struct Ray {
+    glm::vec3 origin;
+    glm::vec3 direction;
+    float tMax;
+};
+
 struct Voxel {
     /*
         DATA SENT TO THE GPU
@@ -26,15 +38,35 @@ struct Voxel {
     glm::vec3 position;
     AABB aabb;
 
-    bool operator<(Voxel& a) {
-        return glm::all(glm::lessThan(position, a.position));
+    // Lexicographic in x, y, z, so voxels can be sorted by position
+    bool operator<(const Voxel& a) const {
+        if (position.x != a.position.x) return position.x < a.position.x;
+        if (position.y != a.position.y) return position.y < a.position.y;
+        return position.z < a.position.z;
     }
 
-    bool operator==(Voxel& a) {
+    bool operator==(const Voxel& a) const {
         return glm::all(glm::equal(position, a.position));
     }
 };
 
 bool isPointInsideAABB(AABB aabb, glm::vec3 point);
+bool isTriangleIntersectingAABB(glm::vec3 v0, glm::vec3 v1, glm::vec3 v2, AABB aabb);
+glm::vec3 getClosestTrianglePoint(glm::vec3 point, glm::vec3 v0, glm::vec3 v1, glm::vec3 v2);
+
+// Octant bits are | y | z | x |, the octree child order
+uint32_t getAABBPointOctant(AABB aabb, glm::vec3 point);
+uint32_t getAABBChildOctant(AABB parentAABB, AABB childAABB);
+AABB getAABBChild(AABB parentAABB, uint32_t octant);
+// Bounds of the voxel positions, padded by LENGTH_EPSILON. The octree root and the voxel pyramid share it
+AABB getVoxelBounds(const std::vector<Voxel>& voxels);
+
+uint32_t packVoxelColor(glm::vec3 color);
+glm::vec3 unpackVoxelColor(uint32_t renderData);
+// Octahedral normal as two snorm8 components, x in the low byte
+uint16_t packOctahedralNormal(glm::vec3 normal);
+glm::vec3 unpackOctahedralNormal(uint16_t packedNormal);
+// Cell holding a point among the 2^(depth - 1) cells per axis of the bounds, the octree frame
+glm::uvec3 getVoxelCell(AABB bounds, uint32_t depth, glm::vec3 position);
 
 #endif
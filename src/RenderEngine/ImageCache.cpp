@@ -0,0 +1,23 @@
+#include "ImageCache.hpp"
+
+ImageCache::ImageCache() {}
+
+ImageCache::~ImageCache() {
+    for (const auto& image : images)
+        delete image.second;
+}
+
+const ImageData* ImageCache::requireImage(std::string imagePath) {
+    auto match = images.find(imagePath);
+    if (match == images.end())
+        match = images.emplace(imagePath, new ImageData(Utils::loadImageFile(imagePath))).first;
+
+    return match->second->loaded ? match->second : nullptr;
+}
+
+size_t ImageCache::getMemoryUsage() {
+    size_t memoryUsage = 0;
+    for (const auto& image : images)
+        memoryUsage += image.second->data.capacity();
+    return memoryUsage;
+}
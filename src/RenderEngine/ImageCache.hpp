@@ -0,0 +1,22 @@
+#ifndef _IMAGECACHE_H_
+#define _IMAGECACHE_H_
+
+#include <map>
+#include <string>
+#include "Utils.hpp"
+
+// Decoded RGBA8 images by path, so every file is decoded once. The texture pool
+// uploads from it and the voxelizer samples it on the CPU. Images that fail to
+// load are remembered too and come back as nullptr. Not thread safe.
+class ImageCache {
+public:
+    ImageCache();
+    ~ImageCache();
+
+    const ImageData* requireImage(std::string imagePath);
+    size_t getMemoryUsage();
+private:
+    std::map<std::string, ImageData*> images;
+};
+
+#endif
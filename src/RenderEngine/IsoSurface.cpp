@@ -0,0 +1,313 @@
+#include "IsoSurface.hpp"
+
+// Corner c of a cube is at (c & 1, c >> 1 & 1, c >> 2 & 1). Edge e runs along
+// axis e / 4 from the corner holding the bits e & 3 on the two other axes
+static int getEdgeAxis(int edge) {
+    return edge / 4;
+}
+
+static int getEdgeCorner(int edge) {
+    int axis = edge / 4;
+    return ((edge & 1) << ((axis + 1) % 3)) | (((edge >> 1) & 1) << ((axis + 2) % 3));
+}
+
+static glm::ivec3 getCornerOffset(int corner) {
+    return glm::ivec3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1);
+}
+
+Mesh* IsoSurface::extract(const Volume& volume, int threadCount) {
+    auto startTime = std::chrono::steady_clock::now();
+    ThreadPool pool(std::max(threadCount, 1));
+
+    // Distance fields are sampled directly, occupancy comes from the solid spans or else the surface cells
+    VoxelRows rows = {};
+    if (volume.distanceField == nullptr && !volume.solidSpans.empty())
+        rows = Voxelizer::getSpanRows(volume.solidSpans);
+    else if (volume.distanceField == nullptr && !volume.voxels.empty())
+        rows = Voxelizer::getShellRows(volume.voxels);
+
+    // Vertex colors are looked up in the voxels sorted by cell
+    std::vector<MortonVoxel> cellKeys(volume.voxels.size());
+    for (uint32_t i = 0; i < volume.voxels.size(); i++)
+        cellKeys[i] = {getCellKey(glm::ivec3(glm::floor(volume.voxels[i].position))), i};
+    Morton::radixSort(cellKeys, 60);
+
+    std::vector<glm::ivec3> chunks = getChunks(volume, rows);
+    const size_t sampleCount = (size_t)ISO_SURFACE_CHUNK_SAMPLES * ISO_SURFACE_CHUNK_SAMPLES * ISO_SURFACE_CHUNK_SAMPLES;
+    const size_t edgeCount = (size_t)3 * (ISO_SURFACE_CHUNK + 1) * (ISO_SURFACE_CHUNK + 1) * (ISO_SURFACE_CHUNK + 1);
+    std::vector<std::vector<float>> workerSamples(pool.getThreadCount(), std::vector<float>(sampleCount));
+    std::vector<std::vector<IsoSurfaceEdge>> workerEdgeCaches(pool.getThreadCount(), std::vector<IsoSurfaceEdge>(edgeCount, {UINT32_MAX, 0}));
+
+    // Chunks are polygonized apart and joined in chunk order, so the mesh does not depend on the thread count
+    std::vector<IsoSurfaceChunk> chunkOutputs(chunks.size());
+    for (uint32_t chunk = 0; chunk < chunks.size(); chunk++)
+        pool.submit([&volume, &rows, &cellKeys, &chunks, &workerSamples, &workerEdgeCaches, &chunkOutputs, &pool, chunk]() {
+            uint32_t worker = pool.getWorkerIndex();
+            extractChunk(volume, rows, cellKeys, chunks[chunk], chunk, workerSamples[worker], workerEdgeCaches[worker], chunkOutputs[chunk]);
+        });
+    pool.wait();
+
+    // Border vertices are computed the same way by every chunk sharing their edge, the first one is kept
+    std::unordered_map<uint64_t, uint32_t> borderVertices;
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    size_t weldedCount = 0;
+    for (IsoSurfaceChunk& output : chunkOutputs) {
+        std::vector<uint32_t> remap(output.vertices.size(), UINT32_MAX);
+        for (const auto& [key, vertex] : output.borderVertices) {
+            auto match = borderVertices.find(key);
+            if (match != borderVertices.end()) {
+                remap[vertex] = match->second;
+                weldedCount++;
+            }
+        }
+        for (uint32_t vertex = 0; vertex < output.vertices.size(); vertex++) {
+            if (remap[vertex] != UINT32_MAX) continue;
+            remap[vertex] = vertices.size();
+            vertices.push_back(output.vertices[vertex]);
+        }
+        for (const auto& [key, vertex] : output.borderVertices)
+            borderVertices.emplace(key, remap[vertex]);
+        for (uint32_t index : output.indices)
+            indices.push_back(remap[index]);
+        output = IsoSurfaceChunk();
+    }
+
+    double extractionTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    double cellCount = (double)chunks.size() * ISO_SURFACE_CHUNK * ISO_SURFACE_CHUNK * ISO_SURFACE_CHUNK;
+    std::string sourceName = volume.distanceField != nullptr ? "distance field" : (volume.solidSpans.empty() ? "surface voxels" : "solid");
+    spdlog::info("Isosurface of the " + sourceName + ": " + std::to_string(vertices.size()) + " vertices and " + std::to_string(indices.size() / 3) + " triangles from " + std::to_string(chunks.size()) + " chunks (" + std::to_string(weldedCount) + " seam vertices welded) in " + std::to_string(extractionTime) + " ms, " + std::to_string(cellCount / (extractionTime * 1000.0)) + " M cells/s.");
+
+    Mesh* surfaceMesh = new Mesh();
+    surfaceMesh->setVertices(vertices);
+    surfaceMesh->setIndices(indices);
+    return surfaceMesh;
+}
+
+void IsoSurface::extractChunk(const Volume& volume, const VoxelRows& rows, const std::vector<MortonVoxel>& cellKeys, glm::ivec3 chunk, uint32_t chunkNumber, std::vector<float>& samples, std::vector<IsoSurfaceEdge>& edgeCache, IsoSurfaceChunk& output) {
+    const int chunkSize = ISO_SURFACE_CHUNK;
+    const int sampleSize = ISO_SURFACE_CHUNK_SAMPLES;
+    glm::ivec3 origin = chunk * chunkSize;
+    if (!fillSamples(volume, rows, origin, samples)) return;
+
+    // Lattice points are local to the chunk, samples start one point before it
+    auto getSample = [&](glm::ivec3 point) -> float {
+        return samples[((size_t)(point.y + 1) * sampleSize + point.z + 1) * sampleSize + point.x + 1];
+    };
+    auto getGradient = [&](glm::ivec3 point) -> glm::vec3 {
+        return glm::vec3(
+            getSample(point + glm::ivec3(1, 0, 0)) - getSample(point - glm::ivec3(1, 0, 0)),
+            getSample(point + glm::ivec3(0, 1, 0)) - getSample(point - glm::ivec3(0, 1, 0)),
+            getSample(point + glm::ivec3(0, 0, 1)) - getSample(point - glm::ivec3(0, 0, 1))
+        );
+    };
+
+    // One vertex per crossed edge, interpolated from its lower end so every chunk gets the same one
+    auto getEdgeVertex = [&](glm::ivec3 point, int axis) -> uint32_t {
+        size_t slot = (((size_t)axis * (chunkSize + 1) + point.y) * (chunkSize + 1) + point.z) * (chunkSize + 1) + point.x;
+        if (edgeCache[slot].chunk == chunkNumber)
+            return edgeCache[slot].vertex;
+
+        glm::ivec3 step = glm::ivec3(0);
+        step[axis] = 1;
+        float start = getSample(point);
+        float end = getSample(point + step);
+        float t = start / (start - end);
+
+        glm::ivec3 cell = origin + point;
+        glm::vec3 position = glm::vec3(cell) + 0.5f;
+        position[axis] += t;
+        glm::vec3 normal = glm::mix(getGradient(point), getGradient(point + step), t);
+        if (glm::length(normal) == 0.0f)
+            normal = glm::vec3(step) * (end > start ? 1.0f : -1.0f);
+
+        // The color of the inside cell, or of the outside one for cells without voxels
+        glm::ivec3 insideCell = start < 0.0f ? cell : cell + step;
+        glm::ivec3 outsideCell = start < 0.0f ? cell + step : cell;
+        glm::vec3 color = getVoxelColor(volume, cellKeys, insideCell);
+        if (color == VOXELIZER_DEFAULT_COLOR)
+            color = getVoxelColor(volume, cellKeys, outsideCell);
+
+        uint32_t vertex = output.vertices.size();
+        output.vertices.push_back({
+            .position = position,
+            .normal = glm::normalize(normal),
+            .color = color
+        });
+
+        int uAxis = (axis + 1) % 3;
+        int vAxis = (axis + 2) % 3;
+        if (point[uAxis] == 0 || point[uAxis] == chunkSize || point[vAxis] == 0 || point[vAxis] == chunkSize)
+            output.borderVertices.push_back({(getCellKey(cell) << 2) | (uint64_t)axis, vertex});
+
+        edgeCache[slot] = {chunkNumber, vertex};
+        return vertex;
+    };
+
+    const std::array<std::array<int8_t, 16>, 256>& caseTable = getCaseTable();
+    for (int y = 0; y < chunkSize; y++)
+        for (int z = 0; z < chunkSize; z++)
+            for (int x = 0; x < chunkSize; x++) {
+                glm::ivec3 cube = glm::ivec3(x, y, z);
+                uint32_t caseIndex = 0;
+                for (int corner = 0; corner < 8; corner++)
+                    if (getSample(cube + getCornerOffset(corner)) < 0.0f)
+                        caseIndex |= 1 << corner;
+                if (caseIndex == 0 || caseIndex == 255) continue;
+
+                for (int i = 0; caseTable[caseIndex][i] >= 0; i++) {
+                    int edge = caseTable[caseIndex][i];
+                    output.indices.push_back(getEdgeVertex(cube + getCornerOffset(getEdgeCorner(edge)), getEdgeAxis(edge)));
+                }
+            }
+}
+
+bool IsoSurface::fillSamples(const Volume& volume, const VoxelRows& rows, glm::ivec3 origin, std::vector<float>& samples) {
+    const int sampleSize = ISO_SURFACE_CHUNK_SAMPLES;
+    glm::ivec3 first = origin - 1;
+    size_t insideCount = 0;
+
+    if (volume.distanceField != nullptr) {
+        DistanceField* field = volume.distanceField.get();
+        for (int y = 0; y < sampleSize; y++)
+            for (int z = 0; z < sampleSize; z++)
+                for (int x = 0; x < sampleSize; x++) {
+                    float distance = field->getDistance(first + glm::ivec3(x, y, z));
+                    distance = std::clamp(distance, -ISO_SURFACE_MAX_DISTANCE, ISO_SURFACE_MAX_DISTANCE);
+                    samples[((size_t)y * sampleSize + z) * sampleSize + x] = distance;
+                    insideCount += distance < 0.0f;
+                }
+    }
+    else {
+        // Spans of every row crossing the sampled block, clipped to it
+        std::fill(samples.begin(), samples.end(), ISO_SURFACE_EMPTY);
+        for (int y = std::max(first.y, rows.minCell.y); y < std::min(first.y + sampleSize, rows.minCell.y + rows.size.y); y++)
+            for (int z = std::max(first.z, rows.minCell.z); z < std::min(first.z + sampleSize, rows.minCell.z + rows.size.z); z++) {
+                size_t row = (size_t)(y - rows.minCell.y) * rows.size.z + z - rows.minCell.z;
+                for (uint32_t i = rows.rowOffsets[row]; i < rows.rowOffsets[row + 1]; i++) {
+                    int xBegin = std::max(rows.spans[i].xBegin, first.x);
+                    int xEnd = std::min(rows.spans[i].xEnd, first.x + sampleSize);
+                    float* rowSamples = &samples[((size_t)(y - first.y) * sampleSize + z - first.z) * sampleSize];
+                    for (int x = xBegin; x < xEnd; x++)
+                        rowSamples[x - first.x] = ISO_SURFACE_OCCUPIED;
+                    insideCount += std::max(xEnd - xBegin, 0);
+                }
+            }
+    }
+
+    // Blocks all inside or all outside have no surface
+    return insideCount > 0 && insideCount < samples.size();
+}
+
+std::vector<glm::ivec3> IsoSurface::getChunks(const Volume& volume, const VoxelRows& rows) {
+    // A cube holds the surface only if one of its corners is inside. Cube m has
+    // corners m to m + 1, so the cubes of an inside sample start at it and one before
+    std::vector<uint64_t> chunkKeys;
+    if (volume.distanceField != nullptr) {
+        glm::ivec3 minCell = volume.distanceField->getMinCell();
+        glm::ivec3 maxCell = minCell + volume.distanceField->getSize() - 1;
+        for (int y = floorDivide(minCell.y - 1, ISO_SURFACE_CHUNK); y <= floorDivide(maxCell.y, ISO_SURFACE_CHUNK); y++)
+            for (int z = floorDivide(minCell.z - 1, ISO_SURFACE_CHUNK); z <= floorDivide(maxCell.z, ISO_SURFACE_CHUNK); z++)
+                for (int x = floorDivide(minCell.x - 1, ISO_SURFACE_CHUNK); x <= floorDivide(maxCell.x, ISO_SURFACE_CHUNK); x++)
+                    chunkKeys.push_back(getCellKey(glm::ivec3(x, y, z)));
+    }
+    else {
+        for (const VoxelSpan& span : rows.spans)
+            for (int y = floorDivide(span.y - 1, ISO_SURFACE_CHUNK); y <= floorDivide(span.y, ISO_SURFACE_CHUNK); y++)
+                for (int z = floorDivide(span.z - 1, ISO_SURFACE_CHUNK); z <= floorDivide(span.z, ISO_SURFACE_CHUNK); z++)
+                    for (int x = floorDivide(span.xBegin - 1, ISO_SURFACE_CHUNK); x <= floorDivide(span.xEnd - 1, ISO_SURFACE_CHUNK); x++)
+                        chunkKeys.push_back(getCellKey(glm::ivec3(x, y, z)));
+    }
+    std::sort(chunkKeys.begin(), chunkKeys.end());
+    chunkKeys.erase(std::unique(chunkKeys.begin(), chunkKeys.end()), chunkKeys.end());
+
+    std::vector<glm::ivec3> chunks(chunkKeys.size());
+    const uint64_t axisMask = (1ull << 20) - 1;
+    for (size_t i = 0; i < chunkKeys.size(); i++)
+        chunks[i] = glm::ivec3(chunkKeys[i] & axisMask, chunkKeys[i] >> 40, (chunkKeys[i] >> 20) & axisMask) - glm::ivec3(ISO_SURFACE_CELL_BIAS);
+    return chunks;
+}
+
+glm::vec3 IsoSurface::getVoxelColor(const Volume& volume, const std::vector<MortonVoxel>& cellKeys, glm::ivec3 cell) {
+    uint64_t key = getCellKey(cell);
+    auto match = std::lower_bound(cellKeys.begin(), cellKeys.end(), key, [](const MortonVoxel& cellKey, uint64_t key) -> bool {
+        return cellKey.code < key;
+    });
+    if (match == cellKeys.end() || match->code != key)
+        return VOXELIZER_DEFAULT_COLOR;
+    return unpackVoxelColor(volume.voxels[match->index].renderData);
+}
+
+const std::array<std::array<int8_t, 16>, 256>& IsoSurface::getCaseTable() {
+    static const std::array<std::array<int8_t, 16>, 256> caseTable = []() {
+        std::array<std::array<int8_t, 16>, 256> table;
+        for (int caseIndex = 0; caseIndex < 256; caseIndex++) {
+            auto isInside = [caseIndex](int corner) -> bool {
+                return (caseIndex >> corner) & 1;
+            };
+            auto getEdge = [](int from, int to) -> int {
+                int axis = std::countr_zero((uint32_t)(from ^ to));
+                int corner = std::min(from, to);
+                return axis * 4 + ((corner >> ((axis + 1) % 3)) & 1) + (((corner >> ((axis + 2) % 3)) & 1) << 1);
+            };
+
+            // Going around every face counterclockwise from outside the cube, each crossing from
+            // an inside corner to an outside one is joined to the next crossing back inside
+            int nextEdge[12];
+            std::fill(nextEdge, nextEdge + 12, -1);
+            for (int axis = 0; axis < 3; axis++)
+                for (int side = 0; side < 2; side++) {
+                    int uAxis = (axis + 1) % 3;
+                    int vAxis = (axis + 2) % 3;
+                    int corners[4] = {0, 1 << uAxis, (1 << uAxis) | (1 << vAxis), 1 << vAxis};
+                    for (int& corner : corners)
+                        corner |= side << axis;
+                    if (side == 0)
+                        std::swap(corners[1], corners[3]);
+
+                    for (int i = 0; i < 4; i++) {
+                        if (!isInside(corners[i]) || isInside(corners[(i + 1) % 4])) continue;
+                        for (int j = 1; j < 4; j++) {
+                            int from = corners[(i + j) % 4];
+                            int to = corners[(i + j + 1) % 4];
+                            if (!isInside(from) && isInside(to)) {
+                                nextEdge[getEdge(corners[i], corners[(i + 1) % 4])] = getEdge(from, to);
+                                break;
+                            }
+                        }
+                    }
+                }
+
+            // The joined crossings close into loops around the inside corners
+            int entry = 0;
+            bool visited[12] = {};
+            for (int edge = 0; edge < 12; edge++) {
+                if (nextEdge[edge] < 0 || visited[edge]) continue;
+                std::vector<int> loop;
+                for (int loopEdge = edge; !visited[loopEdge]; loopEdge = nextEdge[loopEdge]) {
+                    visited[loopEdge] = true;
+                    loop.push_back(loopEdge);
+                }
+                // The loops run clockwise seen from outside, fans are wound back to counterclockwise
+                for (size_t i = 1; i + 1 < loop.size(); i++) {
+                    table[caseIndex][entry++] = loop[0];
+                    table[caseIndex][entry++] = loop[i + 1];
+                    table[caseIndex][entry++] = loop[i];
+                }
+            }
+            std::fill(table[caseIndex].begin() + entry, table[caseIndex].end(), -1);
+        }
+        return table;
+    }();
+    return caseTable;
+}
+
+uint64_t IsoSurface::getCellKey(glm::ivec3 cell) {
+    // y, z, x like the rest of the voxel data, so sorted keys go row by row
+    glm::uvec3 biased = glm::uvec3(cell + ISO_SURFACE_CELL_BIAS);
+    return ((uint64_t)biased.y << 40) | ((uint64_t)biased.z << 20) | (uint64_t)biased.x;
+}
+
+int IsoSurface::floorDivide(int value, int divisor) {
+    return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
@@ -0,0 +1,71 @@
+#ifndef _ISO_SURFACE_HPP_
+#define _ISO_SURFACE_HPP_
+
+#include <stdint.h>
+#include <vector>
+#include <array>
+#include <string>
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include <spdlog/spdlog.h>
+
+#include "Mesh.hpp"
+#include "Morton.hpp"
+#include "ThreadPool.hpp"
+#include "Voxelizer.hpp"
+
+// Cubes per axis of an extraction chunk, each chunk is polygonized by one task
+#define ISO_SURFACE_CHUNK_BITS 5
+#define ISO_SURFACE_CHUNK (1 << ISO_SURFACE_CHUNK_BITS)
+// Samples per axis of a chunk: its cube corners plus one sample on each side for the gradients
+#define ISO_SURFACE_CHUNK_SAMPLES (ISO_SURFACE_CHUNK + 3)
+// Added to lattice coordinates for the cell and edge keys, 20 bits per axis
+#define ISO_SURFACE_CELL_BIAS (1 << 19)
+// Distances are clamped to this many cells, so cells nobody wrote interpolate like far ones
+#define ISO_SURFACE_MAX_DISTANCE 4.0f
+// Occupancy samples of empty and occupied cells, the surface runs halfway between them
+#define ISO_SURFACE_EMPTY 0.5f
+#define ISO_SURFACE_OCCUPIED -0.5f
+
+// Edge cache entry. Entries of older chunks are told apart by the chunk number
+struct IsoSurfaceEdge {
+    uint32_t chunk;
+    uint32_t vertex;
+};
+
+// Triangles of one chunk, and which of its vertices lie on edges other chunks share
+struct IsoSurfaceChunk {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<std::pair<uint64_t, uint32_t>> borderVertices;
+};
+
+/*
+    Marching cubes over the voxel grid. Samples sit at the cell centers, and
+    are the signed distance field of the volume when it has one, otherwise
+    the occupancy of its solid or surface cells. Chunks share the vertices of
+    their cube edges through an edge cache, and vertices on the chunk borders
+    are welded when the chunks are joined, so seams are closed and indexed
+    like the rest of the surface. The case table is built from the cube faces:
+    every face splits its inside corners from the outside ones the same way
+    for both cubes sharing it, which keeps the surface free of holes.
+*/
+class IsoSurface {
+public:
+    static Mesh* extract(const Volume& volume, int threadCount);
+private:
+    IsoSurface();
+
+    static void extractChunk(const Volume& volume, const VoxelRows& rows, const std::vector<MortonVoxel>& cellKeys, glm::ivec3 chunk, uint32_t chunkNumber, std::vector<float>& samples, std::vector<IsoSurfaceEdge>& edgeCache, IsoSurfaceChunk& output);
+    static bool fillSamples(const Volume& volume, const VoxelRows& rows, glm::ivec3 origin, std::vector<float>& samples);
+    static std::vector<glm::ivec3> getChunks(const Volume& volume, const VoxelRows& rows);
+    static glm::vec3 getVoxelColor(const Volume& volume, const std::vector<MortonVoxel>& cellKeys, glm::ivec3 cell);
+    static const std::array<std::array<int8_t, 16>, 256>& getCaseTable();
+    static uint64_t getCellKey(glm::ivec3 cell);
+    static int floorDivide(int value, int divisor);
+};
+
+#endif
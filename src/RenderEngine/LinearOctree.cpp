@@ -0,0 +1,297 @@
+#include "LinearOctree.hpp"
+
+LinearOctree::LinearOctree() {
+    this->maxDepth = 0;
+    this->nodeCount = 0;
+    this->descriptors = nullptr;
+    this->normals = nullptr;
+    this->colors = nullptr;
+    this->mappedData = nullptr;
+    this->mappedSize = 0;
+}
+
+LinearOctree::~LinearOctree() {
+    clear();
+}
+
+void LinearOctree::build(Octree* octree) {
+    clear();
+
+    ONode* root = octree->getRoot();
+    if (octree->isEmpty()) return;
+
+    bounds = root->getVoxel().aabb;
+    maxDepth = octree->getMaxDepth();
+
+    // Breadth first walk, so every node's children end up next to each other
+    std::vector<ONode*> queue = {root};
+    for (size_t i = 0; i < queue.size(); i++) {
+        ONode* node = queue[i];
+        Voxel nodeVoxel = node->getVoxel();
+
+        // Order the children by octant, only the present ones are stored
+        ONode* octantChildren[8] = {nullptr};
+        for (ONode* child : node->children)
+            octantChildren[getAABBChildOctant(nodeVoxel.aabb, child->getVoxel().aabb)] = child;
+
+        ChildDescriptor descriptor = {
+            .firstChild = (uint32_t)queue.size(),
+            .childMask = 0,
+            .leafMask = 0,
+            .padding = 0
+        };
+
+        for (uint32_t octant = 0; octant < 8; octant++) {
+            ONode* child = octantChildren[octant];
+            if (child == nullptr) continue;
+
+            descriptor.childMask |= 1 << octant;
+            if (child->children.size() == 0)
+                descriptor.leafMask |= 1 << octant;
+            queue.push_back(child);
+        }
+
+        descriptorStorage.push_back(descriptor);
+        normalStorage.push_back(nodeVoxel.normal);
+        colorStorage.push_back(nodeVoxel.renderData);
+    }
+
+    descriptorStorage.shrink_to_fit();
+    normalStorage.shrink_to_fit();
+    colorStorage.shrink_to_fit();
+
+    nodeCount = descriptorStorage.size();
+    descriptors = descriptorStorage.data();
+    normals = normalStorage.data();
+    colors = colorStorage.data();
+}
+
+bool LinearOctree::saveToFile(std::string path) {
+    if (nodeCount == 0) {
+        spdlog::warn("SVO file " + path + " not written. The octree is empty.");
+        return false;
+    }
+
+    SVOHeader header = {};
+    header.magic = SVO_MAGIC;
+    header.version = SVO_VERSION;
+    header.maxDepth = maxDepth;
+    header.nodeCount = nodeCount;
+    header.descriptorOffset = alignOffset(sizeof(SVOHeader));
+    header.normalOffset = alignOffset(header.descriptorOffset + nodeCount * sizeof(ChildDescriptor));
+    header.colorOffset = alignOffset(header.normalOffset + nodeCount * sizeof(glm::vec3));
+    header.boundsMin = bounds.min;
+    header.boundsMax = bounds.max;
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        spdlog::warn("Failed to open SVO file for writing: " + path);
+        return false;
+    }
+
+    // Zero padding up to the start of each section
+    const char padding[SVO_SECTION_ALIGNMENT] = {0};
+    file.write((const char*)&header, sizeof(SVOHeader));
+    file.write(padding, header.descriptorOffset - sizeof(SVOHeader));
+    file.write((const char*)descriptors, nodeCount * sizeof(ChildDescriptor));
+    file.write(padding, header.normalOffset - (header.descriptorOffset + nodeCount * sizeof(ChildDescriptor)));
+    file.write((const char*)normals, nodeCount * sizeof(glm::vec3));
+    file.write(padding, header.colorOffset - (header.normalOffset + nodeCount * sizeof(glm::vec3)));
+    file.write((const char*)colors, nodeCount * sizeof(uint32_t));
+
+    if (!file) {
+        spdlog::warn("Failed to write SVO file: " + path);
+        return false;
+    }
+
+    spdlog::info("SVO file " + path + " successfully written.");
+    return true;
+}
+
+bool LinearOctree::loadFromFile(std::string path) {
+    clear();
+
+    int fileDescriptor = open(path.c_str(), O_RDONLY);
+    if (fileDescriptor == -1) {
+        spdlog::warn("Failed to open SVO file: " + path);
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(fileDescriptor, &fileStat) == -1 || (size_t)fileStat.st_size < sizeof(SVOHeader)) {
+        spdlog::warn("Invalid SVO file: " + path);
+        close(fileDescriptor);
+        return false;
+    }
+
+    // The mapping stays valid after closing the descriptor
+    void* data = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    close(fileDescriptor);
+    if (data == MAP_FAILED) {
+        spdlog::warn("Failed to map SVO file: " + path);
+        return false;
+    }
+
+    mappedData = data;
+    mappedSize = fileStat.st_size;
+
+    const SVOHeader* header = (const SVOHeader*)mappedData;
+    if (header->magic != SVO_MAGIC || header->version != SVO_VERSION) {
+        spdlog::warn("Unsupported SVO file format or version: " + path);
+        clear();
+        return false;
+    }
+
+    if (!isSectionInside(header->descriptorOffset, header->nodeCount, sizeof(ChildDescriptor), mappedSize) ||
+        !isSectionInside(header->normalOffset, header->nodeCount, sizeof(glm::vec3), mappedSize) ||
+        !isSectionInside(header->colorOffset, header->nodeCount, sizeof(uint32_t), mappedSize)) {
+        spdlog::warn("Truncated or misaligned SVO file: " + path);
+        clear();
+        return false;
+    }
+
+    if (header->maxDepth < 1 || header->maxDepth > MORTON_MAX_LEVELS + 1) {
+        spdlog::warn("Invalid SVO depth " + std::to_string(header->maxDepth) + " in " + path);
+        clear();
+        return false;
+    }
+
+    maxDepth = header->maxDepth;
+    nodeCount = header->nodeCount;
+    bounds.min = header->boundsMin;
+    bounds.max = header->boundsMax;
+    bounds.center = (bounds.min + bounds.max) / 2.0f;
+
+    const char* bytes = (const char*)mappedData;
+    descriptors = (const ChildDescriptor*)(bytes + header->descriptorOffset);
+    normals = (const glm::vec3*)(bytes + header->normalOffset);
+    colors = (const uint32_t*)(bytes + header->colorOffset);
+
+    // The traversals follow the descriptors unchecked, so they are checked once here
+    if (!isTreeValid()) {
+        spdlog::warn("Corrupt child descriptors in SVO file: " + path);
+        clear();
+        return false;
+    }
+
+    spdlog::info("SVO file " + path + " successfully mapped.");
+    return true;
+}
+
+Mesh* LinearOctree::compressToMesh(uint32_t depth) {
+    std::vector<VoxelVertex> vertices;
+    if (nodeCount > 0)
+        traverseGettingLeaves(0, bounds, 1, depth, vertices);
+
+    // Points are drawn in order, no index buffer
+    Mesh* volumeRenderMesh = new Mesh();
+    volumeRenderMesh->setVoxelVertices(vertices, depth);
+    return volumeRenderMesh;
+}
+
+void LinearOctree::traverseGettingLeaves(uint32_t nodeIndex, AABB nodeAABB, uint32_t depth, uint32_t maxTraverseDepth, std::vector<VoxelVertex>& vertices) {
+    if (depth > maxTraverseDepth || depth > maxDepth)
+        return;
+
+    ChildDescriptor descriptor = descriptors[nodeIndex];
+    if (descriptor.childMask == 0) {
+        // Is leaf
+        vertices.push_back(VoxelVertex::pack(getVoxelCell(bounds, maxTraverseDepth, nodeAABB.center), normals[nodeIndex], colors[nodeIndex]));
+        return;
+    }
+
+    uint32_t childIndex = descriptor.firstChild;
+    for (uint32_t octant = 0; octant < 8; octant++)
+        if (descriptor.childMask & (1 << octant))
+            traverseGettingLeaves(childIndex++, getAABBChild(nodeAABB, octant), depth + 1, maxTraverseDepth, vertices);
+}
+
+std::vector<Mesh*> LinearOctree::getDebugMeshes() {
+    std::vector<Mesh*> meshes;
+    if (nodeCount > 0)
+        traverseGettingMeshes(0, bounds, 1, meshes);
+    return meshes;
+}
+
+void LinearOctree::traverseGettingMeshes(uint32_t nodeIndex, AABB nodeAABB, uint32_t depth, std::vector<Mesh*>& meshes) {
+    if (depth > maxDepth)
+        return;
+
+    float ratio = 2.0f * (depth - 1) / (maxDepth - 1);
+    float r = std::max(0.0f, ratio - 1.0f);
+    float b = std::max(0.0f, 1.0f - ratio);
+    float g = 1.0f - b - r;
+
+    meshes.push_back(Utils::getDebugBoxMesh(nodeAABB, glm::vec3(r, g, b)));
+
+    ChildDescriptor descriptor = descriptors[nodeIndex];
+    uint32_t childIndex = descriptor.firstChild;
+    for (uint32_t octant = 0; octant < 8; octant++)
+        if (descriptor.childMask & (1 << octant))
+            traverseGettingMeshes(childIndex++, getAABBChild(nodeAABB, octant), depth + 1, meshes);
+}
+
+AABB LinearOctree::getBounds() {
+    return bounds;
+}
+
+uint32_t LinearOctree::getMaxDepth() {
+    return maxDepth;
+}
+
+size_t LinearOctree::getNodeCount() {
+    return nodeCount;
+}
+
+size_t LinearOctree::getMemoryUsage() {
+    return nodeCount * (sizeof(ChildDescriptor) + sizeof(glm::vec3) + sizeof(uint32_t));
+}
+
+bool LinearOctree::isEqual(const LinearOctree& other) {
+    if (maxDepth != other.maxDepth || nodeCount != other.nodeCount || bounds.min != other.bounds.min || bounds.max != other.bounds.max)
+        return false;
+    if (nodeCount == 0)
+        return true;
+
+    // Bit for bit, as the arrays are written and mapped
+    return std::memcmp(descriptors, other.descriptors, nodeCount * sizeof(ChildDescriptor)) == 0 &&
+        std::memcmp(normals, other.normals, nodeCount * sizeof(glm::vec3)) == 0 &&
+        std::memcmp(colors, other.colors, nodeCount * sizeof(uint32_t)) == 0;
+}
+
+void LinearOctree::clear() {
+    descriptorStorage.clear();
+    normalStorage.clear();
+    colorStorage.clear();
+
+    if (mappedData != nullptr)
+        munmap(mappedData, mappedSize);
+    mappedData = nullptr;
+    mappedSize = 0;
+
+    nodeCount = 0;
+    descriptors = nullptr;
+    normals = nullptr;
+    colors = nullptr;
+}
+
+bool LinearOctree::isTreeValid() {
+    // Children come after their parent in breadth first order, so no walk can loop,
+    // and every child list has to fit in the node arrays
+    for (size_t i = 0; i < nodeCount; i++) {
+        ChildDescriptor descriptor = descriptors[i];
+        if (descriptor.childMask == 0) continue;
+        if (descriptor.firstChild <= i || (uint64_t)descriptor.firstChild + std::popcount(descriptor.childMask) > nodeCount)
+            return false;
+    }
+    return true;
+}
+
+bool LinearOctree::isSectionInside(uint64_t offset, uint64_t count, size_t elementSize, size_t fileSize) {
+    // Written so that huge counts or offsets can not overflow
+    return offset % SVO_SECTION_ALIGNMENT == 0 && offset <= fileSize && count <= (fileSize - offset) / elementSize;
+}
+
+uint64_t LinearOctree::alignOffset(uint64_t offset) {
+    return (offset + SVO_SECTION_ALIGNMENT - 1) & ~(uint64_t)(SVO_SECTION_ALIGNMENT - 1);
+}
@@ -0,0 +1,103 @@
+#ifndef _LINEAR_OCTREE_HPP_
+#define _LINEAR_OCTREE_HPP_
+
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <bit>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <glm/glm.hpp>
+
+#include "Octree.hpp"
+#include "Utils.hpp"
+#include "Geometry.hpp"
+
+/*
+    CHILD DESCRIPTOR
+    64 bits
+
+    | firstChild (32) | childMask (8) | leafMask (8) | padding (16) |
+
+    Children of a node are stored contiguously in breadth first order, only
+    for the octants set in childMask. Octant bits are | y | z | x |, matching
+    the Octree child order. A child's slot is the popcount of the mask bits
+    below its octant.
+*/
+struct ChildDescriptor {
+    uint32_t firstChild;
+    uint8_t childMask;
+    uint8_t leafMask;
+    uint16_t padding;
+};
+
+/*
+    SVO FILE
+    Little endian, every section aligned to SVO_SECTION_ALIGNMENT bytes
+
+    | SVOHeader | ChildDescriptor[nodeCount] | vec3 normals[nodeCount] | uint32_t colors[nodeCount] |
+
+    The arrays are used straight from the memory mapping, nothing is deserialized.
+*/
+#define SVO_MAGIC 0x314F5653 // "SVO1"
+#define SVO_VERSION 1
+#define SVO_SECTION_ALIGNMENT 64
+
+struct SVOHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t maxDepth;
+    uint32_t reserved;
+    uint64_t nodeCount;
+    uint64_t descriptorOffset;
+    uint64_t normalOffset;
+    uint64_t colorOffset;
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+};
+
+class LinearOctree {
+public:
+    LinearOctree();
+    ~LinearOctree();
+
+    void build(Octree* octree);
+    bool saveToFile(std::string path);
+    bool loadFromFile(std::string path);
+    Mesh* compressToMesh(uint32_t depth);
+    std::vector<Mesh*> getDebugMeshes();
+    AABB getBounds();
+    uint32_t getMaxDepth();
+    size_t getNodeCount();
+    size_t getMemoryUsage();
+    bool isEqual(const LinearOctree& other);
+private:
+    AABB bounds;
+    uint32_t maxDepth;
+    size_t nodeCount;
+
+    // Either point into the storage vectors or into a mapped .svo file
+    const ChildDescriptor* descriptors;
+    const glm::vec3* normals;
+    const uint32_t* colors;
+
+    std::vector<ChildDescriptor> descriptorStorage;
+    std::vector<glm::vec3> normalStorage;
+    std::vector<uint32_t> colorStorage;
+    void* mappedData;
+    size_t mappedSize;
+
+    void clear();
+    bool isTreeValid();
+    static bool isSectionInside(uint64_t offset, uint64_t count, size_t elementSize, size_t fileSize);
+    static uint64_t alignOffset(uint64_t offset);
+
+    void traverseGettingLeaves(uint32_t nodeIndex, AABB nodeAABB, uint32_t depth, uint32_t maxTraverseDepth, std::vector<VoxelVertex>& vertices);
+    void traverseGettingMeshes(uint32_t nodeIndex, AABB nodeAABB, uint32_t depth, std::vector<Mesh*>& meshes);
+};
+
+#endif
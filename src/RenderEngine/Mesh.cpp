@@ -1,6 +1,21 @@
 #include "Mesh.hpp"
 
-Mesh::Mesh() {}
+VoxelVertex VoxelVertex::pack(glm::uvec3 cell, glm::vec3 normal, uint32_t renderData) {
+    // renderData is | MaterialID | R | G | B |, the vertex color is read as R8G8B8A8
+    cell = glm::min(cell, glm::uvec3(0xFFFF));
+    uint32_t color = ((renderData >> 16) & 0xFF) | (renderData & 0xFF00) | ((renderData & 0xFF) << 16) | 0xFF000000;
+    return {
+        .cell = {(uint16_t)cell.x, (uint16_t)cell.y, (uint16_t)cell.z},
+        .normal = packOctahedralNormal(normal),
+        .color = color
+    };
+}
+
+Mesh::Mesh() {
+    this->vertexBuffer = nullptr;
+    this->indexBuffer = nullptr;
+    this->voxelDepth = 0;
+}
 
 Mesh::~Mesh() {
     #ifndef NDEBUG
@@ -12,6 +27,11 @@ void Mesh::setVertices(std::vector<Vertex> vertices) {
     this->vertices = vertices;
 }
 
+void Mesh::setVoxelVertices(std::vector<VoxelVertex> voxelVertices, uint32_t voxelDepth) {
+    this->voxelVertices = voxelVertices;
+    this->voxelDepth = voxelDepth;
+}
+
 void Mesh::setIndices(std::vector<uint32_t> indices) {
     this->indices = indices;
 }
@@ -24,33 +44,38 @@ std::vector<Vertex> Mesh::getVertices() {
     return vertices;
 }
 
+std::vector<VoxelVertex> Mesh::getVoxelVertices() {
+    return voxelVertices;
+}
+
+uint32_t Mesh::getVoxelDepth() {
+    return voxelDepth;
+}
+
 std::vector<uint32_t> Mesh::getIndices() {
     return indices;
 }
 
 void Mesh::uploadMesh(Device* device) {
     // Vertices need to have data
-    if (vertices.size() == 0) {
+    if (vertices.size() == 0 && voxelVertices.size() == 0) {
         spdlog::warn("Mesh data could not be uploaded to the GPU. No vertices found.");
         return;
     }
 
-    // Indices need to have data if vertices size is greater than or equal to three
-    if (indices.size() == 0) {
-        spdlog::warn("Mesh data could not be uploaded to the GPU. No indices found.");
-        return;
-       
-    }
-
-    // Allocate the mesh buffer with the vertices data
+    // Allocate the mesh buffer with the vertices data, in whichever format the mesh holds
+    bool isVoxelMesh = voxelVertices.size() > 0;
     vertexBuffer = new Buffer (
         device,
-        vertices.data(),
-        vertices.size() * sizeof(Vertex),
+        isVoxelMesh ? (void*)voxelVertices.data() : (void*)vertices.data(),
+        isVoxelMesh ? voxelVertices.size() * sizeof(VoxelVertex) : vertices.size() * sizeof(Vertex),
         vk::BufferUsageFlagBits::eVertexBuffer,
         vk::MemoryPropertyFlagBits::eHostCoherent | vk::MemoryPropertyFlagBits::eHostVisible
     );
 
+    // Meshes without indices are drawn in vertex order and get no index buffer
+    if (indices.size() == 0) return;
+
     // Allocate the mesh buffer with the indices data
     indexBuffer = new Buffer (
         device,
@@ -73,6 +98,10 @@ std::vector<Material> Mesh::getMaterials() {
     return materials;
 }
 
+uint32_t Mesh::getNumVertices() {
+    return vertices.size() > 0 ? vertices.size() : voxelVertices.size();
+}
+
 uint32_t Mesh::getNumIndices() {
     return indices.size();
 }
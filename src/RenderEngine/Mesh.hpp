@@ -69,6 +69,52 @@ struct Vertex {
     }
 };
 
+// Point of the voxel pipeline, 12 bytes instead of the 44 of a Vertex
+struct VoxelVertex {
+    // Cell at the rendered depth, counted from the octree's minimum corner
+    uint16_t cell[3];
+    // Octahedral normal, see packOctahedralNormal
+    uint16_t normal;
+    // | A | B | G | R |, R in the lowest byte
+    uint32_t color;
+
+    static VoxelVertex pack(glm::uvec3 cell, glm::vec3 normal, uint32_t renderData);
+
+    // Instanced cubes read one voxel vertex per instance instead of per vertex
+    static VertexInputDescription getVertexDescription(vk::VertexInputRate inputRate = vk::VertexInputRate::eVertex) {
+        VertexInputDescription description;
+
+        // Vertex input binding description
+        vk::VertexInputBindingDescription vertexInputBindingDescription (
+            0,
+            sizeof(VoxelVertex),
+            inputRate
+        );
+
+        description.bindings.push_back(vertexInputBindingDescription);
+
+        // Cell and normal binding (0), the normal is unpacked from w by the shader
+        vk::VertexInputAttributeDescription cellAttribute (
+            0,
+            0,
+            vk::Format::eR16G16B16A16Uint,
+            offsetof(VoxelVertex, cell)
+        );
+
+        // Color binding (1)
+        vk::VertexInputAttributeDescription colorAttribute (
+            1,
+            0,
+            vk::Format::eR8G8B8A8Unorm,
+            offsetof(VoxelVertex, color)
+        );
+
+        description.attributes.push_back(cellAttribute);
+        description.attributes.push_back(colorAttribute);
+        return description;
+    }
+};
+
 struct Material {
     glm::vec3 ambientColor;
     glm::vec3 diffuseColor;
@@ -98,13 +144,17 @@ public:
     bool hasNormals;
 
     void setVertices(std::vector<Vertex> vertices);
+    void setVoxelVertices(std::vector<VoxelVertex> voxelVertices, uint32_t voxelDepth);
     void setIndices(std::vector<uint32_t> indices);
     void setMaterials(std::vector<Material> materials);
     std::vector<Vertex> getVertices();
+    std::vector<VoxelVertex> getVoxelVertices();
+    uint32_t getVoxelDepth();
     std::vector<uint32_t> getIndices();
     Buffer* getVertexBuffer();
     Buffer* getIndexBuffer();
     std::vector<Material> getMaterials();
+    uint32_t getNumVertices();
     uint32_t getNumIndices();
     AABB getBoundingBox();
     void uploadMesh(Device* device);
@@ -112,10 +162,15 @@ public:
     void translateByMatrix(glm::mat4 translationMatrix);
 private:
     std::vector<Vertex> vertices;
+    // Voxel pipeline meshes hold these instead of vertices
+    std::vector<VoxelVertex> voxelVertices;
+    // Octree depth the voxel cells were packed at, the shaders size the voxels from it
+    uint32_t voxelDepth;
     std::vector<uint32_t> indices;
     std::vector<Material> materials;
 
     Buffer* vertexBuffer;
+    // nullptr for meshes without indices
     Buffer* indexBuffer;
 };
 
@@ -0,0 +1,57 @@
+#include "Morton.hpp"
+
+uint64_t Morton::encode(glm::uvec3 cell) {
+    // Interleave as | y | z | x | per level, so sorted codes follow the octree child order
+    return spreadBits(cell.x) | (spreadBits(cell.z) << 1) | (spreadBits(cell.y) << 2);
+}
+
+glm::uvec3 Morton::decode(uint64_t code) {
+    return glm::uvec3(compactBits(code), compactBits(code >> 2), compactBits(code >> 1));
+}
+
+void Morton::radixSort(std::vector<MortonVoxel>& voxels, uint32_t bits) {
+    if (voxels.size() < 2) return;
+
+    // LSD radix sort with 8 bits digits, only over the bits that are actually used
+    std::vector<MortonVoxel> buffer(voxels.size());
+    for (uint32_t shift = 0; shift < bits; shift += 8) {
+        size_t counts[256] = {0};
+        for (const MortonVoxel& voxel : voxels)
+            counts[(voxel.code >> shift) & 0xFF]++;
+
+        // Skip the pass if every code shares the same digit
+        if (counts[(voxels[0].code >> shift) & 0xFF] == voxels.size())
+            continue;
+
+        size_t offset = 0;
+        for (uint32_t i = 0; i < 256; i++) {
+            size_t count = counts[i];
+            counts[i] = offset;
+            offset += count;
+        }
+
+        for (const MortonVoxel& voxel : voxels)
+            buffer[counts[(voxel.code >> shift) & 0xFF]++] = voxel;
+        voxels.swap(buffer);
+    }
+}
+
+uint64_t Morton::spreadBits(uint32_t value) {
+    uint64_t x = value & 0x1FFFFF;
+    x = (x | x << 32) & 0x001F00000000FFFF;
+    x = (x | x << 16) & 0x001F0000FF0000FF;
+    x = (x | x << 8)  & 0x100F00F00F00F00F;
+    x = (x | x << 4)  & 0x10C30C30C30C30C3;
+    x = (x | x << 2)  & 0x1249249249249249;
+    return x;
+}
+
+uint32_t Morton::compactBits(uint64_t value) {
+    uint64_t x = value & 0x1249249249249249;
+    x = (x | x >> 2)  & 0x10C30C30C30C30C3;
+    x = (x | x >> 4)  & 0x100F00F00F00F00F;
+    x = (x | x >> 8)  & 0x001F0000FF0000FF;
+    x = (x | x >> 16) & 0x001F00000000FFFF;
+    x = (x | x >> 32) & 0x1FFFFF;
+    return (uint32_t)x;
+}
@@ -0,0 +1,28 @@
+#ifndef _MORTON_H_
+#define _MORTON_H_
+
+#include <stdint.h>
+#include <vector>
+#include <glm/glm.hpp>
+
+// 21 bits per axis fit into a 64 bit Morton code
+#define MORTON_MAX_LEVELS 21
+
+struct MortonVoxel {
+    uint64_t code;
+    uint32_t index;
+};
+
+class Morton {
+public:
+    static uint64_t encode(glm::uvec3 cell);
+    static glm::uvec3 decode(uint64_t code);
+    static void radixSort(std::vector<MortonVoxel>& voxels, uint32_t bits);
+private:
+    Morton();
+
+    static uint64_t spreadBits(uint32_t value);
+    static uint32_t compactBits(uint64_t value);
+};
+
+#endif
@@ -0,0 +1,66 @@
+#include "NodeArena.hpp"
+
+NodeArena::NodeArena() {
+    blockOffset = 0;
+    usedBytes = 0;
+    nodeCount = 0;
+    childListCount = 0;
+}
+
+NodeArena::~NodeArena() {
+    release();
+}
+
+ONode* NodeArena::allocateNode() {
+    nodeCount++;
+    return new (allocate(sizeof(ONode), alignof(ONode))) ONode();
+}
+
+ONode** NodeArena::allocateChildren(uint32_t count) {
+    childListCount++;
+    return (ONode**)allocate(count * sizeof(ONode*), alignof(ONode*));
+}
+
+void NodeArena::release() {
+    // ONode is never destructed, dropping the blocks frees the whole tree
+    for (char* block : blocks)
+        ::operator delete(block);
+    blocks.clear();
+
+    blockOffset = 0;
+    usedBytes = 0;
+    nodeCount = 0;
+    childListCount = 0;
+}
+
+size_t NodeArena::getNodeCount() {
+    return nodeCount;
+}
+
+size_t NodeArena::getChildListCount() {
+    return childListCount;
+}
+
+size_t NodeArena::getBlockCount() {
+    return blocks.size();
+}
+
+size_t NodeArena::getReservedBytes() {
+    return blocks.size() * NODE_ARENA_BLOCK_SIZE;
+}
+
+size_t NodeArena::getUsedBytes() {
+    return usedBytes;
+}
+
+void* NodeArena::allocate(size_t size, size_t alignment) {
+    size_t offset = (blockOffset + alignment - 1) & ~(alignment - 1);
+    if (blocks.size() == 0 || offset + size > NODE_ARENA_BLOCK_SIZE) {
+        blocks.push_back((char*)::operator new(NODE_ARENA_BLOCK_SIZE));
+        offset = 0;
+    }
+
+    blockOffset = offset + size;
+    usedBytes += size;
+    return blocks.back() + offset;
+}
@@ -0,0 +1,38 @@
+#ifndef _NODE_ARENA_HPP_
+#define _NODE_ARENA_HPP_
+
+#include <stdint.h>
+#include <vector>
+#include <new>
+
+#include "ONode.hpp"
+
+#define NODE_ARENA_BLOCK_SIZE (1 << 20)
+
+// Bump allocator for octree nodes and child lists. Memory is only given back
+// all at once, by release() or the destructor. Not thread safe, parallel
+// builds use one arena per worker.
+class NodeArena {
+public:
+    NodeArena();
+    ~NodeArena();
+
+    ONode* allocateNode();
+    ONode** allocateChildren(uint32_t count);
+    void release();
+    size_t getNodeCount();
+    size_t getChildListCount();
+    size_t getBlockCount();
+    size_t getReservedBytes();
+    size_t getUsedBytes();
+private:
+    std::vector<char*> blocks;
+    size_t blockOffset;
+    size_t usedBytes;
+    size_t nodeCount;
+    size_t childListCount;
+
+    void* allocate(size_t size, size_t alignment);
+};
+
+#endif
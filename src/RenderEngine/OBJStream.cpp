@@ -0,0 +1,208 @@
+#include "OBJStream.hpp"
+
+OBJStream::OBJStream(std::string path) {
+    this->path = path;
+    this->file = std::fopen(path.c_str(), "rb");
+    this->buffer = std::vector<char>(OBJ_STREAM_BUFFER_SIZE);
+    this->bufferBegin = 0;
+    this->bufferEnd = 0;
+    this->positionFile = nullptr;
+    this->positions = nullptr;
+    this->mappedSize = 0;
+    this->bounds = {
+        .min = glm::vec3(std::numeric_limits<float>::max()),
+        .max = glm::vec3(std::numeric_limits<float>::lowest()),
+        .center = glm::vec3(0.0f)
+    };
+    this->vertexCount = 0;
+    this->faceVertexCount = 0;
+    this->triangleCount = 0;
+    this->polygonTriangle = 0;
+}
+
+OBJStream::~OBJStream() {
+    if (positions != nullptr)
+        munmap((void*)positions, mappedSize);
+
+    // The temporary position file is deleted on close
+    if (positionFile != nullptr)
+        std::fclose(positionFile);
+    if (file != nullptr)
+        std::fclose(file);
+}
+
+bool OBJStream::readVertices() {
+    if (file == nullptr) {
+        spdlog::warn("Failed to open OBJ file: " + path);
+        return false;
+    }
+
+    positionFile = std::tmpfile();
+    if (positionFile == nullptr) {
+        spdlog::warn("Failed to create a temporary position file for " + path);
+        return false;
+    }
+
+    // A short write would leave the mapping past the end of the file, so every write is checked
+    std::vector<glm::vec3> pending;
+    pending.reserve(1 << 16);
+    auto writePending = [&]() {
+        if (std::fwrite(pending.data(), sizeof(glm::vec3), pending.size(), positionFile) != pending.size()) {
+            spdlog::error("Failed to write the positions of " + path + " to the temporary position file");
+            return false;
+        }
+        vertexCount += pending.size();
+        pending.clear();
+        return true;
+    };
+    std::string_view line;
+    while (readLine(line)) {
+        if (line.size() < 2 || line[0] != 'v' || (line[1] != ' ' && line[1] != '\t')) continue;
+        line.remove_prefix(2);
+
+        glm::vec3 position;
+        if (!parseFloat(line, position.x) || !parseFloat(line, position.y) || !parseFloat(line, position.z)) {
+            spdlog::warn("Malformed vertex in OBJ file: " + path);
+            return false;
+        }
+
+        bounds.min = glm::min(bounds.min, position);
+        bounds.max = glm::max(bounds.max, position);
+        pending.push_back(position);
+        if (pending.size() == pending.capacity() && !writePending())
+            return false;
+    }
+    if (!writePending())
+        return false;
+    if (std::fflush(positionFile) != 0) {
+        spdlog::error("Failed to flush the temporary position file of " + path);
+        return false;
+    }
+
+    if (vertexCount == 0) {
+        spdlog::warn("No vertices in OBJ file: " + path);
+        return false;
+    }
+    bounds.center = (bounds.min + bounds.max) / 2.0f;
+
+    mappedSize = vertexCount * sizeof(glm::vec3);
+    void* data = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fileno(positionFile), 0);
+    if (data == MAP_FAILED) {
+        spdlog::warn("Failed to map the positions of " + path);
+        return false;
+    }
+    positions = (const glm::vec3*)data;
+
+    return rewindFile();
+}
+
+bool OBJStream::readTriangles(std::vector<glm::vec3>& triangles, size_t maxTriangles) {
+    triangles.clear();
+    if (positions == nullptr) return false;
+
+    std::string_view line;
+    while (true) {
+        // Fan triangles of the last polygon read, the previous chunk may have left some
+        for (; polygonTriangle + 1 < polygon.size() && triangles.size() / 3 < maxTriangles; polygonTriangle++)
+            triangles.insert(triangles.end(), {polygon[0], polygon[polygonTriangle], polygon[polygonTriangle + 1]});
+        if (triangles.size() / 3 >= maxTriangles || !readLine(line)) break;
+
+        if (line.size() < 2 || (line[1] != ' ' && line[1] != '\t')) continue;
+        if (line[0] == 'v') {
+            faceVertexCount++;
+            continue;
+        }
+        if (line[0] != 'f') continue;
+        line.remove_prefix(2);
+
+        polygon.clear();
+        polygonTriangle = 1;
+        int64_t index;
+        while (parseIndex(line, index)) {
+            // Negative indices count back from the last vertex read so far
+            int64_t vertex = index > 0 ? index - 1 : (int64_t)faceVertexCount + index;
+            if (vertex < 0 || vertex >= (int64_t)vertexCount) {
+                spdlog::warn("Face index out of range in OBJ file: " + path);
+                polygon.clear();
+                break;
+            }
+            polygon.push_back(positions[vertex]);
+        }
+    }
+
+    triangleCount += triangles.size() / 3;
+    return !triangles.empty();
+}
+
+AABB OBJStream::getBounds() {
+    return bounds;
+}
+
+size_t OBJStream::getVertexCount() {
+    return vertexCount;
+}
+
+size_t OBJStream::getTriangleCount() {
+    return triangleCount;
+}
+
+bool OBJStream::rewindFile() {
+    bufferBegin = 0;
+    bufferEnd = 0;
+    return std::fseek(file, 0, SEEK_SET) == 0;
+}
+
+bool OBJStream::readLine(std::string_view& line) {
+    while (true) {
+        char* begin = buffer.data() + bufferBegin;
+        char* newline = (char*)std::memchr(begin, '\n', bufferEnd - bufferBegin);
+        if (newline != nullptr) {
+            line = std::string_view(begin, newline - begin);
+            bufferBegin += line.size() + 1;
+            return true;
+        }
+
+        // Keep the partial line and refill behind it, lines longer than the buffer grow it
+        size_t remaining = bufferEnd - bufferBegin;
+        std::memmove(buffer.data(), begin, remaining);
+        bufferBegin = 0;
+        bufferEnd = remaining;
+        if (bufferEnd == buffer.size())
+            buffer.resize(buffer.size() * 2);
+
+        size_t readBytes = std::fread(buffer.data() + bufferEnd, 1, buffer.size() - bufferEnd, file);
+        if (readBytes == 0) {
+            // Last line without a newline
+            if (remaining == 0) return false;
+            line = std::string_view(buffer.data(), remaining);
+            bufferEnd = 0;
+            return true;
+        }
+        bufferEnd += readBytes;
+    }
+}
+
+bool OBJStream::parseFloat(std::string_view& text, float& value) {
+    skipSpaces(text);
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (error != std::errc()) return false;
+    text.remove_prefix(end - text.data());
+    return true;
+}
+
+bool OBJStream::parseIndex(std::string_view& text, int64_t& index) {
+    skipSpaces(text);
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), index);
+    if (error != std::errc() || index == 0) return false;
+    text.remove_prefix(end - text.data());
+
+    // Texture coordinate and normal indices are skipped
+    while (!text.empty() && text[0] != ' ' && text[0] != '\t' && text[0] != '\r')
+        text.remove_prefix(1);
+    return true;
+}
+
+void OBJStream::skipSpaces(std::string_view& text) {
+    while (!text.empty() && (text[0] == ' ' || text[0] == '\t' || text[0] == '\r'))
+        text.remove_prefix(1);
+}
@@ -0,0 +1,66 @@
+#ifndef _OBJ_STREAM_HPP_
+#define _OBJ_STREAM_HPP_
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <limits>
+#include <sys/mman.h>
+#include <glm/glm.hpp>
+#include <spdlog/spdlog.h>
+
+#include "Geometry.hpp"
+
+// Bytes read from the OBJ file at a time
+#define OBJ_STREAM_BUFFER_SIZE (1 << 22)
+
+/*
+    Reads the triangles of an OBJ file without loading it.
+
+    readVertices() is the first pass: it collects the bounds and writes the
+    positions to an unnamed temporary file, mapped back read only, so they
+    are paged in by the faces that use them instead of living on the heap.
+    readTriangles() is the second pass and hands out fan triangulated faces
+    in chunks of at most maxTriangles, splitting polygons between chunks
+    when they do not fit. Only "v" and "f" lines are read, materials are ignored.
+*/
+class OBJStream {
+public:
+    OBJStream(std::string path);
+    ~OBJStream();
+
+    bool readVertices();
+    bool readTriangles(std::vector<glm::vec3>& triangles, size_t maxTriangles);
+    AABB getBounds();
+    size_t getVertexCount();
+    size_t getTriangleCount();
+private:
+    std::string path;
+    FILE* file;
+    std::vector<char> buffer;
+    size_t bufferBegin, bufferEnd;
+
+    FILE* positionFile;
+    const glm::vec3* positions;
+    size_t mappedSize;
+
+    AABB bounds;
+    size_t vertexCount;
+    size_t faceVertexCount;
+    size_t triangleCount;
+    std::vector<glm::vec3> polygon;
+    // Next fan triangle of polygon, chunks end exactly at maxTriangles
+    size_t polygonTriangle;
+
+    bool rewindFile();
+    bool readLine(std::string_view& line);
+    static bool parseFloat(std::string_view& text, float& value);
+    static bool parseIndex(std::string_view& text, int64_t& index);
+    static void skipSpaces(std::string_view& text);
+};
+
+#endif
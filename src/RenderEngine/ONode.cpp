@@ -2,15 +2,14 @@
 
 ONode::ONode() {
     this->isLeaf = false;
+    this->children = {nullptr, 0};
+    this->voxelCount = 0;
+    this->normalSum = glm::vec3(0.0f);
+    this->colorSum = glm::vec3(0.0f);
 }
 
-ONode::~ONode() {
-    for (const auto child : children)
-        delete child;
-}
-
-void ONode::addChild(ONode* child) {
-    children.push_back(child);
+void ONode::setChildren(ONode** children, uint32_t count) {
+    this->children = {children, count};
 }
 
 //void ONode::setVoxelRenderData(uint8_t materialID, uint8_t r, uint8_t g, uint8_t b) {
@@ -7,14 +7,33 @@
 
 #include "Geometry.hpp"
 
+class ONode;
+
+// Non owning view over a child list allocated in the octree arena
+struct ONodeChildren {
+    ONode** nodes;
+    uint32_t count;
+
+    ONode** begin() const { return nodes; }
+    ONode** end() const { return nodes + count; }
+    uint32_t size() const { return count; }
+    ONode* operator[](uint32_t index) const { return nodes[index]; }
+};
+
+// Nodes and their child lists live in a NodeArena owned by the octree, so they
+// are never destroyed one by one
 class ONode {
 public:
     ONode();
-    ~ONode();
 
-    std::vector<ONode*> children;
+    ONodeChildren children;
+
+    // Running totals over every voxel inside the node, kept so edits can refresh the averages
+    uint32_t voxelCount;
+    glm::vec3 normalSum;
+    glm::vec3 colorSum;
 
-    void addChild(ONode* child);
+    void setChildren(ONode** children, uint32_t count);
     void setVoxel(Voxel voxel);
     Voxel getVoxel();
 private:
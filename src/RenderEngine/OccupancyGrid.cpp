@@ -0,0 +1,205 @@
+#include "OccupancyGrid.hpp"
+
+OccupancyGrid::OccupancyGrid(glm::ivec3 minCell, glm::ivec3 maxCell, bool allowDense) {
+    this->minCell = minCell;
+    this->maxCell = glm::max(maxCell, minCell);
+    this->size = this->maxCell - minCell + 1;
+    this->cellCount = 0;
+    this->lastPageKey = UINT64_MAX;
+    this->lastPage = 0;
+
+    dense = allowDense && fitsDense(minCell, this->maxCell);
+    if (dense)
+        bits = std::vector<uint64_t>(((uint64_t)size.x * size.y * size.z + 63) / 64, 0);
+}
+
+bool OccupancyGrid::insert(glm::ivec3 cell) {
+    if (glm::any(glm::lessThan(cell, minCell)) || glm::any(glm::greaterThan(cell, maxCell)))
+        return false;
+
+    uint64_t* word;
+    uint64_t mask;
+    if (dense) {
+        uint64_t bit = getDenseBit(cell);
+        word = &bits[bit >> 6];
+        mask = 1ull << (bit & 63);
+    }
+    else {
+        uint32_t bit = getPageBit(cell);
+        word = &findPage(getPageKey(cell), true)->bits[bit >> 6];
+        mask = 1ull << (bit & 63);
+    }
+
+    if (*word & mask) return false;
+    *word |= mask;
+    cellCount++;
+    return true;
+}
+
+bool OccupancyGrid::contains(glm::ivec3 cell) {
+    if (glm::any(glm::lessThan(cell, minCell)) || glm::any(glm::greaterThan(cell, maxCell)))
+        return false;
+
+    if (dense) {
+        uint64_t bit = getDenseBit(cell);
+        return (bits[bit >> 6] >> (bit & 63)) & 1;
+    }
+
+    OccupancyPage* page = findPage(getPageKey(cell), false);
+    if (page == nullptr) return false;
+    uint32_t bit = getPageBit(cell);
+    return (page->bits[bit >> 6] >> (bit & 63)) & 1;
+}
+
+void OccupancyGrid::buildCellIndices() {
+    if (dense) {
+        wordRanks = std::vector<uint32_t>(bits.size());
+        uint32_t rank = 0;
+        for (size_t i = 0; i < bits.size(); i++) {
+            wordRanks[i] = rank;
+            rank += std::popcount(bits[i]);
+        }
+        return;
+    }
+
+    // Pages are numbered in key order, so indices follow the page grid y, z, x
+    std::sort(pages.begin(), pages.end(), [](const OccupancyPage& a, const OccupancyPage& b) -> bool {
+        return a.key < b.key;
+    });
+
+    uint32_t rank = 0;
+    pageIndices.clear();
+    for (uint32_t i = 0; i < pages.size(); i++) {
+        OccupancyPage& page = pages[i];
+        page.firstIndex = rank;
+        for (uint32_t j = 0; j < OCCUPANCY_PAGE_WORDS; j++) {
+            page.wordRanks[j] = rank - page.firstIndex;
+            rank += std::popcount(page.bits[j]);
+        }
+        pageIndices[page.key] = i;
+    }
+    lastPageKey = UINT64_MAX;
+}
+
+uint32_t OccupancyGrid::getCellIndex(glm::ivec3 cell) {
+    // Rank of the cell's bit, only valid for occupied cells after buildCellIndices()
+    if (dense) {
+        uint64_t bit = getDenseBit(cell);
+        uint64_t below = bits[bit >> 6] & ((1ull << (bit & 63)) - 1);
+        return wordRanks[bit >> 6] + std::popcount(below);
+    }
+
+    OccupancyPage* page = findPage(getPageKey(cell), false);
+    uint32_t bit = getPageBit(cell);
+    uint64_t below = page->bits[bit >> 6] & ((1ull << (bit & 63)) - 1);
+    return page->firstIndex + page->wordRanks[bit >> 6] + std::popcount(below);
+}
+
+std::vector<glm::ivec3> OccupancyGrid::getCells() {
+    // Occupied cells in cell index order
+    std::vector<glm::ivec3> cells;
+    cells.reserve(cellCount);
+
+    if (dense) {
+        for (size_t i = 0; i < bits.size(); i++) {
+            for (uint64_t word = bits[i]; word != 0; word &= word - 1) {
+                uint64_t bit = i * 64 + std::countr_zero(word);
+                int x = bit % size.x;
+                int z = (bit / size.x) % size.z;
+                int y = bit / ((uint64_t)size.x * size.z);
+                cells.push_back(minCell + glm::ivec3(x, y, z));
+            }
+        }
+        return cells;
+    }
+
+    for (const OccupancyPage& page : pages) {
+        glm::ivec3 pageOrigin = minCell + OCCUPANCY_PAGE_SIZE * glm::ivec3(
+            page.key & 0x1FFFFF,
+            page.key >> 42,
+            (page.key >> 21) & 0x1FFFFF
+        );
+        for (uint32_t i = 0; i < OCCUPANCY_PAGE_WORDS; i++) {
+            for (uint64_t word = page.bits[i]; word != 0; word &= word - 1) {
+                uint32_t bit = i * 64 + std::countr_zero(word);
+                glm::ivec3 local = glm::ivec3(
+                    bit & (OCCUPANCY_PAGE_SIZE - 1),
+                    bit >> (2 * OCCUPANCY_PAGE_BITS),
+                    (bit >> OCCUPANCY_PAGE_BITS) & (OCCUPANCY_PAGE_SIZE - 1)
+                );
+                cells.push_back(pageOrigin + local);
+            }
+        }
+    }
+    return cells;
+}
+
+glm::ivec3 OccupancyGrid::getMinCell() {
+    return minCell;
+}
+
+glm::ivec3 OccupancyGrid::getMaxCell() {
+    return maxCell;
+}
+
+size_t OccupancyGrid::getCellCount() {
+    return cellCount;
+}
+
+size_t OccupancyGrid::getPageCount() {
+    return pages.size();
+}
+
+size_t OccupancyGrid::getMemoryUsage() {
+    if (dense)
+        return bits.capacity() * sizeof(uint64_t) + wordRanks.capacity() * sizeof(uint32_t);
+
+    // Map nodes hold the key, the page index and the bucket chain pointer
+    size_t mapBytes = pageIndices.bucket_count() * sizeof(void*) + pageIndices.size() * (sizeof(std::pair<uint64_t, uint32_t>) + sizeof(void*));
+    return pages.capacity() * sizeof(OccupancyPage) + mapBytes;
+}
+
+bool OccupancyGrid::isDense() {
+    return dense;
+}
+
+bool OccupancyGrid::fitsDense(glm::ivec3 minCell, glm::ivec3 maxCell) {
+    glm::ivec3 size = glm::max(maxCell, minCell) - minCell + 1;
+    return (uint64_t)size.x * size.y * size.z <= OCCUPANCY_GRID_DENSE_LIMIT;
+}
+
+uint64_t OccupancyGrid::getDenseBit(glm::ivec3 cell) {
+    glm::ivec3 local = cell - minCell;
+    return ((uint64_t)local.y * size.z + local.z) * size.x + local.x;
+}
+
+uint64_t OccupancyGrid::getPageKey(glm::ivec3 cell) {
+    // 21 bits per page coordinate, y, z, x from the most significant end
+    glm::uvec3 local = glm::uvec3(cell - minCell);
+    return ((uint64_t)(local.y >> OCCUPANCY_PAGE_BITS) << 42) | ((uint64_t)(local.z >> OCCUPANCY_PAGE_BITS) << 21) | (local.x >> OCCUPANCY_PAGE_BITS);
+}
+
+uint32_t OccupancyGrid::getPageBit(glm::ivec3 cell) {
+    glm::uvec3 local = glm::uvec3(cell - minCell);
+    uint32_t mask = OCCUPANCY_PAGE_SIZE - 1;
+    return ((local.y & mask) << (2 * OCCUPANCY_PAGE_BITS)) | ((local.z & mask) << OCCUPANCY_PAGE_BITS) | (local.x & mask);
+}
+
+OccupancyPage* OccupancyGrid::findPage(uint64_t key, bool create) {
+    if (key == lastPageKey)
+        return &pages[lastPage];
+
+    auto match = pageIndices.find(key);
+    if (match == pageIndices.end()) {
+        if (!create) return nullptr;
+
+        OccupancyPage page = {};
+        page.key = key;
+        match = pageIndices.emplace(key, (uint32_t)pages.size()).first;
+        pages.push_back(page);
+    }
+
+    lastPageKey = key;
+    lastPage = match->second;
+    return &pages[lastPage];
+}
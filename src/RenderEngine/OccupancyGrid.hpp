@@ -0,0 +1,72 @@
+#ifndef _OCCUPANCY_GRID_HPP_
+#define _OCCUPANCY_GRID_HPP_
+
+#include <stdint.h>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <bit>
+#include <glm/glm.hpp>
+
+// Grids with up to this many cells keep one flat bitset, larger ones allocate pages on demand
+#define OCCUPANCY_GRID_DENSE_LIMIT (1ull << 27)
+// Pages are 16x16x16 cells, 64 words of 64 bits
+#define OCCUPANCY_PAGE_BITS 4
+#define OCCUPANCY_PAGE_SIZE (1 << OCCUPANCY_PAGE_BITS)
+#define OCCUPANCY_PAGE_WORDS (OCCUPANCY_PAGE_SIZE * OCCUPANCY_PAGE_SIZE * OCCUPANCY_PAGE_SIZE / 64)
+
+struct OccupancyPage {
+    uint64_t key;
+    uint32_t firstIndex;
+    // Occupied cells before every word of the page
+    uint16_t wordRanks[OCCUPANCY_PAGE_WORDS];
+    uint64_t bits[OCCUPANCY_PAGE_WORDS];
+};
+
+// One bit per integer cell of [minCell, maxCell]. Cells are laid out y, z, x,
+// the octree octant order, in the dense bitset and inside every page.
+//
+// Grids that fit OCCUPANCY_GRID_DENSE_LIMIT are dense unless allowDense is
+// false, so parts of a larger grid can keep its layout and cell order.
+//
+// After buildCellIndices() every occupied cell has a compact index in
+// [0, getCellCount()), the rank of its bit, so per cell attributes live in
+// plain arrays. Not thread safe.
+class OccupancyGrid {
+public:
+    OccupancyGrid(glm::ivec3 minCell, glm::ivec3 maxCell, bool allowDense = true);
+
+    bool insert(glm::ivec3 cell);
+    bool contains(glm::ivec3 cell);
+    void buildCellIndices();
+    uint32_t getCellIndex(glm::ivec3 cell);
+    std::vector<glm::ivec3> getCells();
+    glm::ivec3 getMinCell();
+    glm::ivec3 getMaxCell();
+    size_t getCellCount();
+    size_t getPageCount();
+    size_t getMemoryUsage();
+    bool isDense();
+    static bool fitsDense(glm::ivec3 minCell, glm::ivec3 maxCell);
+private:
+    glm::ivec3 minCell, maxCell, size;
+    bool dense;
+    size_t cellCount;
+
+    // Dense grid
+    std::vector<uint64_t> bits;
+    std::vector<uint32_t> wordRanks;
+
+    // Paged grid, the last page found is cached since cells arrive mostly in surface order
+    std::vector<OccupancyPage> pages;
+    std::unordered_map<uint64_t, uint32_t> pageIndices;
+    uint64_t lastPageKey;
+    uint32_t lastPage;
+
+    uint64_t getDenseBit(glm::ivec3 cell);
+    uint64_t getPageKey(glm::ivec3 cell);
+    uint32_t getPageBit(glm::ivec3 cell);
+    OccupancyPage* findPage(uint64_t key, bool create);
+};
+
+#endif
@@ -2,37 +2,183 @@
 
 Octree::Octree() {
     this->root= nullptr;
+    this->buildPool = nullptr;
 }
 
 Octree::~Octree() {
-    delete root;
+    // Releasing the arenas frees every node at once
+    resetArenas(0);
 }
 
-void Octree::build(std::vector<Voxel> data, uint32_t maxDepth) {
+void Octree::build(std::vector<Voxel> data, uint32_t maxDepth, uint32_t threadCount) {
     // Initiate the octree root voxel
     Voxel rootVoxel;
-    rootVoxel.aabb.min = glm::vec3(std::numeric_limits<float>::max());
-    rootVoxel.aabb.max = glm::vec3(std::numeric_limits<float>::min());
-    rootVoxel.aabb.center = glm::vec3(0.0f, 0.0f, 0.0f);
+    rootVoxel.aabb = getVoxelDataBounds(data);
 
-    for (const auto voxel : data) {
-        if (rootVoxel.aabb.min.x > voxel.position.x) rootVoxel.aabb.min.x = voxel.position.x;
-        if (rootVoxel.aabb.min.y > voxel.position.y) rootVoxel.aabb.min.y = voxel.position.y;
-        if (rootVoxel.aabb.min.z > voxel.position.z) rootVoxel.aabb.min.z = voxel.position.z;
+    // One arena per build thread, so workers never share an allocator
+    resetArenas(std::max(threadCount, 1u));
+    root = arenas[0]->allocateNode();
+    root->setVoxel(rootVoxel);
+    accumulateVoxelData(root, data);
+    this->maxDepth = maxDepth;
 
-        if (rootVoxel.aabb.max.x < voxel.position.x) rootVoxel.aabb.max.x = voxel.position.x;
-        if (rootVoxel.aabb.max.y < voxel.position.y) rootVoxel.aabb.max.y = voxel.position.y;
-        if (rootVoxel.aabb.max.z < voxel.position.z) rootVoxel.aabb.max.z = voxel.position.z;
+    if (threadCount <= 1) {
+        subdivideNode(root, std::move(data), 1);
+        return;
     }
 
-    rootVoxel.aabb.min -= LENGTH_EPSILON;
-    rootVoxel.aabb.max += LENGTH_EPSILON;
-    rootVoxel.aabb.center = (rootVoxel.aabb.min + rootVoxel.aabb.max) / 2.0f;
+    // The top levels are split into tasks. Every node only ever appends to its own children,
+    // so the resulting tree does not depend on the thread count or scheduling
+    ThreadPool pool(threadCount);
+    buildPool = &pool;
+    subdivideNode(root, std::move(data), 1);
+    pool.wait();
+    buildPool = nullptr;
+}
+
+void Octree::buildMorton(const std::vector<Voxel>& data, uint32_t maxDepth) {
+    // Initiate the octree root voxel
+    Voxel rootVoxel;
+    rootVoxel.aabb = getVoxelDataBounds(data);
 
-    root = new ONode();
+    resetArenas(1);
+    NodeArena* arena = arenas[0];
+    root = arena->allocateNode();
     root->setVoxel(rootVoxel);
     this->maxDepth = maxDepth;
-    subdivideNode(root, data, 1);
+    if (maxDepth <= 1 || data.size() == 0) {
+        accumulateVoxelData(root, data);
+        return;
+    }
+
+    if (maxDepth - 1 > MORTON_MAX_LEVELS) {
+        spdlog::warn("Octree depth " + std::to_string(maxDepth) + " exceeds the Morton builder limit. Clamping to " + std::to_string(MORTON_MAX_LEVELS + 1) + ".");
+        this->maxDepth = MORTON_MAX_LEVELS + 1;
+    }
+
+    // Quantize every voxel position into the leaf level grid
+    uint32_t levels = this->maxDepth - 1;
+    uint32_t gridSize = 1u << levels;
+    glm::vec3 rootSize = rootVoxel.aabb.max - rootVoxel.aabb.min;
+    glm::vec3 cellScale = glm::vec3((float)gridSize) / rootSize;
+
+    std::vector<MortonVoxel> mortonVoxels(data.size());
+    for (uint32_t i = 0; i < data.size(); i++) {
+        glm::uvec3 cell = glm::uvec3((data[i].position - rootVoxel.aabb.min) * cellScale);
+        cell = glm::min(cell, glm::uvec3(gridSize - 1));
+        mortonVoxels[i] = {Morton::encode(cell), i};
+    }
+    Morton::radixSort(mortonVoxels, 3 * levels);
+
+    // Each run of equal codes becomes a leaf
+    struct MortonNode {
+        uint64_t code;
+        ONode* node;
+    };
+
+    std::vector<MortonNode> nodes;
+    for (const MortonVoxel& mortonVoxel : mortonVoxels) {
+        if (nodes.size() == 0 || nodes.back().code != mortonVoxel.code)
+            nodes.push_back({mortonVoxel.code, arena->allocateNode()});
+
+        const Voxel& voxel = data[mortonVoxel.index];
+        ONode* leaf = nodes.back().node;
+        leaf->voxelCount++;
+        leaf->normalSum += voxel.normal;
+        leaf->colorSum += unpackVoxelColor(voxel.renderData);
+    }
+
+    // Emit the tree bottom-up, one linear pass per level. Parents group children by dropping the last octant
+    for (uint32_t depth = this->maxDepth; depth > 1; depth--) {
+        glm::vec3 nodeSize = rootSize / (float)(1u << (depth - 1));
+
+        for (MortonNode& mortonNode : nodes) {
+            Voxel nodeVoxel;
+            nodeVoxel.aabb.min = rootVoxel.aabb.min + glm::vec3(Morton::decode(mortonNode.code)) * nodeSize;
+            nodeVoxel.aabb.max = nodeVoxel.aabb.min + nodeSize;
+            nodeVoxel.aabb.center = (nodeVoxel.aabb.min + nodeVoxel.aabb.max) / 2.0f;
+            mortonNode.node->setVoxel(nodeVoxel);
+            refreshNodeVoxel(mortonNode.node);
+        }
+
+        // Siblings are consecutive, so each parent takes one run of equal parent codes
+        std::vector<MortonNode> parents;
+        for (size_t first = 0; first < nodes.size();) {
+            uint64_t parentCode = nodes[first].code >> 3;
+            size_t last = first;
+            while (last < nodes.size() && (nodes[last].code >> 3) == parentCode)
+                last++;
+
+            MortonNode parent = {parentCode, depth == 2 ? root : arena->allocateNode()};
+            ONode** children = arena->allocateChildren(last - first);
+            for (size_t i = first; i < last; i++) {
+                parent.node->voxelCount += nodes[i].node->voxelCount;
+                parent.node->normalSum += nodes[i].node->normalSum;
+                parent.node->colorSum += nodes[i].node->colorSum;
+                children[i - first] = nodes[i].node;
+            }
+            parent.node->setChildren(children, last - first);
+            parents.push_back(parent);
+            first = last;
+        }
+        nodes.swap(parents);
+    }
+
+    refreshNodeVoxel(root);
+}
+
+void Octree::buildFromPyramid(VoxelPyramid& pyramid, uint32_t maxDepth) {
+    // Same tree as buildMorton, but the levels are already quantized, sorted and summed
+    Voxel rootVoxel;
+    rootVoxel.aabb = pyramid.getBounds();
+
+    resetArenas(1);
+    NodeArena* arena = arenas[0];
+    root = arena->allocateNode();
+    root->setVoxel(rootVoxel);
+    this->maxDepth = std::clamp(maxDepth, 1u, std::max(pyramid.getMaxDepth(), 1u));
+    if (pyramid.getMaxDepth() == 0) {
+        refreshNodeVoxel(root);
+        return;
+    }
+
+    // Nodes of the level below, in the order of its cells
+    std::vector<ONode*> children;
+    for (uint32_t depth = this->maxDepth; depth >= 1; depth--) {
+        const std::vector<VoxelPyramidCell>& cells = pyramid.getLevel(depth);
+        const std::vector<VoxelPyramidCell>& childCells = pyramid.getLevel(depth + 1);
+        glm::vec3 nodeSize = (rootVoxel.aabb.max - rootVoxel.aabb.min) / (float)(1u << (depth - 1));
+
+        std::vector<ONode*> nodes(cells.size());
+        size_t child = 0;
+        for (size_t i = 0; i < cells.size(); i++) {
+            ONode* node = depth == 1 ? root : arena->allocateNode();
+            if (depth > 1) {
+                Voxel nodeVoxel;
+                nodeVoxel.aabb.min = rootVoxel.aabb.min + glm::vec3(Morton::decode(cells[i].code)) * nodeSize;
+                nodeVoxel.aabb.max = nodeVoxel.aabb.min + nodeSize;
+                nodeVoxel.aabb.center = (nodeVoxel.aabb.min + nodeVoxel.aabb.max) / 2.0f;
+                node->setVoxel(nodeVoxel);
+            }
+            node->voxelCount = cells[i].voxelCount;
+            node->normalSum = cells[i].normalSum;
+            node->colorSum = cells[i].colorSum;
+
+            // The children are the run of the level below under this cell's code
+            size_t firstChild = child;
+            while (depth < this->maxDepth && child < childCells.size() && (childCells[child].code >> 3) == cells[i].code)
+                child++;
+            if (child > firstChild) {
+                ONode** childList = arena->allocateChildren(child - firstChild);
+                std::copy(children.begin() + firstChild, children.begin() + child, childList);
+                node->setChildren(childList, child - firstChild);
+            }
+
+            refreshNodeVoxel(node);
+            nodes[i] = node;
+        }
+        children.swap(nodes);
+    }
 }
 
 void Octree::subdivideNode(ONode* node, std::vector<Voxel> data, uint32_t depth) {
@@ -40,75 +186,544 @@ void Octree::subdivideNode(ONode* node, std::vector<Voxel> data, uint32_t depth)
 
     Voxel nodeVoxel = node->getVoxel();
     AABB nodeAABB = nodeVoxel.aabb;
-    glm::vec3 aabbSize = nodeAABB.max - nodeAABB.min;
-    for (float j = nodeAABB.min.y; j < nodeAABB.max.y; j += aabbSize.y / 2.0f)
-        for (float k = nodeAABB.min.z; k < nodeAABB.max.z; k += aabbSize.z / 2.0f) 
-            for (float i = nodeAABB.min.x; i < nodeAABB.max.x; i += aabbSize.x / 2.0f) {
-                AABB subAABB;
-                subAABB.min = {i, j ,k};
-                subAABB.max = subAABB.min + aabbSize / 2.0f;
-                subAABB.center = (subAABB.min + subAABB.max) / 2.0f;
-
-                // Check for each voxel inside the parent node
-                std::vector<Voxel> subData;
-                for (const auto voxel : data)
-                    if (isPointInsideAABB(subAABB, voxel.position))
-                        subData.push_back(voxel);
-
-                if (subData.size() > 0) {
-                    Voxel subNodeVoxel;
-                    subNodeVoxel.aabb = subAABB;
-                    subNodeVoxel.normal = getVoxelDataAverageNormal(subData);
-                    subNodeVoxel.renderData = 0x00FF8040;
-
-                    ONode* subNode = new ONode();
-                    subNode->setVoxel(subNodeVoxel);
-                    node->addChild(subNode);
-                    subdivideNode(subNode, subData, depth + 1);
+
+    // Every voxel goes to exactly one octant, by the same rule insert and erase use,
+    // so voxels on a split plane are not counted twice
+    std::vector<Voxel> octantDatas[8];
+    for (const auto& voxel : data)
+        octantDatas[getAABBPointOctant(nodeAABB, voxel.position)].push_back(voxel);
+
+    // Gather the non empty octants first, so the child list is allocated once with its final size
+    ONode* subNodes[8];
+    std::vector<Voxel> subDatas[8];
+    uint32_t subNodeCount = 0;
+
+    NodeArena* arena = getBuildArena();
+    for (uint32_t octant = 0; octant < 8; octant++) {
+        if (octantDatas[octant].size() == 0) continue;
+
+        Voxel subNodeVoxel;
+        subNodeVoxel.aabb = getAABBChild(nodeAABB, octant);
+
+        ONode* subNode = arena->allocateNode();
+        subNode->setVoxel(subNodeVoxel);
+        accumulateVoxelData(subNode, octantDatas[octant]);
+        subNodes[subNodeCount] = subNode;
+        subDatas[subNodeCount] = std::move(octantDatas[octant]);
+        subNodeCount++;
+    }
+
+    if (subNodeCount == 0) return;
+
+    ONode** children = arena->allocateChildren(subNodeCount);
+    std::copy(subNodes, subNodes + subNodeCount, children);
+    node->setChildren(children, subNodeCount);
+
+    // The parent voxels are no longer needed once split
+    data.clear();
+    data.shrink_to_fit();
+
+    for (uint32_t i = 0; i < subNodeCount; i++) {
+        ONode* subNode = subNodes[i];
+        if (buildPool != nullptr && depth < PARALLEL_BUILD_DEPTH)
+            buildPool->submit([this, subNode, subData = std::move(subDatas[i]), depth]() mutable {
+                subdivideNode(subNode, std::move(subData), depth + 1);
+            });
+        else
+            subdivideNode(subNode, std::move(subDatas[i]), depth + 1);
+    }
+}
+
+std::vector<OctreeDirtyLeaf> Octree::insert(std::span<const Voxel> voxels) {
+    std::vector<OctreeDirtyLeaf> dirtyLeaves;
+    if (root == nullptr) {
+        spdlog::warn("Voxels can not be inserted into an octree that was never built.");
+        return dirtyLeaves;
+    }
+
+    std::unordered_set<ONode*> dirtyNodes;
+    std::vector<ONode*> path;
+    uint32_t rejectedCount = 0;
+    AABB rootAABB = root->getVoxel().aabb;
+    for (const Voxel& voxel : voxels) {
+        // The bounds are fixed at build time, voxels outside of them need a rebuild
+        if (!isPointInsideAABB(rootAABB, voxel.position)) {
+            rejectedCount++;
+            continue;
+        }
+
+        // Walk down to the leaf cell, creating the missing nodes on the way
+        glm::vec3 color = unpackVoxelColor(voxel.renderData);
+        ONode* node = root;
+        path.clear();
+        for (uint32_t depth = 1; ; depth++) {
+            node->voxelCount++;
+            node->normalSum += voxel.normal;
+            node->colorSum += color;
+            path.push_back(node);
+            if (depth >= maxDepth) break;
+
+            AABB nodeAABB = node->getVoxel().aabb;
+            uint32_t octant = getAABBPointOctant(nodeAABB, voxel.position);
+            uint32_t slot;
+            ONode* child = findChild(node, octant, slot);
+            if (child == nullptr) {
+                Voxel childVoxel;
+                childVoxel.aabb = getAABBChild(nodeAABB, octant);
+
+                child = arenas[0]->allocateNode();
+                child->setVoxel(childVoxel);
+                insertChild(node, child, octant);
+            }
+            node = child;
+        }
+
+        for (ONode* pathNode : path)
+            refreshNodeVoxel(pathNode);
+
+        if (dirtyNodes.insert(node).second)
+            dirtyLeaves.push_back({node->getVoxel().aabb, node});
+    }
+
+    if (rejectedCount > 0)
+        spdlog::warn(std::to_string(rejectedCount) + " voxels outside of the octree bounds were not inserted.");
+
+    return dirtyLeaves;
+}
+
+std::vector<OctreeDirtyLeaf> Octree::erase(std::span<const glm::vec3> positions) {
+    std::vector<OctreeDirtyLeaf> dirtyLeaves;
+    if (root == nullptr) return dirtyLeaves;
+
+    std::vector<ONode*> path;
+    std::vector<uint32_t> slots;
+    AABB rootAABB = root->getVoxel().aabb;
+    for (const glm::vec3& position : positions) {
+        if (isEmpty()) break;
+        if (!isPointInsideAABB(rootAABB, position)) continue;
+
+        // Find the leaf cell holding the position, if any
+        ONode* node = root;
+        path.clear();
+        slots.clear();
+        path.push_back(node);
+        for (uint32_t depth = 1; depth < maxDepth && node != nullptr; depth++) {
+            uint32_t slot;
+            node = findChild(node, getAABBPointOctant(node->getVoxel().aabb, position), slot);
+            if (node != nullptr) {
+                path.push_back(node);
+                slots.push_back(slot);
+            }
+        }
+        if (node == nullptr) continue;
+
+        // Take the whole cell out of every ancestor total
+        ONode* leaf = path.back();
+        uint32_t leafCount = leaf->voxelCount;
+        glm::vec3 leafNormalSum = leaf->normalSum;
+        glm::vec3 leafColorSum = leaf->colorSum;
+        for (ONode* pathNode : path) {
+            pathNode->voxelCount -= leafCount;
+            pathNode->normalSum -= leafNormalSum;
+            pathNode->colorSum -= leafColorSum;
+        }
+        dirtyLeaves.push_back({leaf->getVoxel().aabb, nullptr});
+
+        // Prune the branches left empty, their memory goes back with the arena
+        uint32_t i = path.size() - 1;
+        for (; i > 0 && path[i]->voxelCount == 0; i--)
+            removeChild(path[i - 1], slots[i - 1]);
+
+        for (; i > 0; i--)
+            refreshNodeVoxel(path[i]);
+
+        // An emptied root keeps its bounds for later inserts, its sums are reset
+        // from whatever the float subtractions left
+        if (root->voxelCount == 0) {
+            root->setChildren(nullptr, 0);
+            root->normalSum = glm::vec3(0.0f);
+            root->colorSum = glm::vec3(0.0f);
+        }
+        refreshNodeVoxel(root);
+    }
+
+    return dirtyLeaves;
+}
+
+Hit Octree::raycast(glm::vec3 origin, glm::vec3 direction, float tMax) {
+    Hit hit = {
+        .leaf = nullptr,
+        .t = tMax,
+        .normal = glm::vec3(0.0f)
+    };
+    if (isEmpty()) return hit;
+
+    Ray ray = {
+        .origin = origin,
+        .direction = direction,
+        .tMax = tMax
+    };
+
+    // Rays going down an axis are mirrored around the root center, so the
+    // traversal only handles positive directions. The mirrored octant bits
+    // are flipped back when a child is looked up
+    AABB rootAABB = root->getVoxel().aabb;
+    uint32_t mirrorMask = 0;
+    const uint32_t axisOctantBits[3] = {1, 4, 2};
+    for (uint32_t axis = 0; axis < 3; axis++) {
+        if (direction[axis] < 0.0f) {
+            origin[axis] = rootAABB.min[axis] + rootAABB.max[axis] - origin[axis];
+            direction[axis] = -direction[axis];
+            mirrorMask |= axisOctantBits[axis];
+        }
+        // Parallel rays get a huge but finite slope so the midpoints stay defined
+        direction[axis] = std::max(direction[axis], 1e-30f);
+    }
+
+    glm::vec3 t0 = (rootAABB.min - origin) / direction;
+    glm::vec3 t1 = (rootAABB.max - origin) / direction;
+    if (glm::compMax(t0) < glm::compMin(t1))
+        raycastNode(root, t0, t1, mirrorMask, ray, hit);
+    return hit;
+}
+
+void Octree::raycast(std::span<const Ray> rays, std::span<Hit> hits, uint32_t threadCount) {
+    if (hits.size() < rays.size()) {
+        spdlog::warn("Raycast hit buffer is smaller than the ray batch. Extra rays are ignored.");
+        rays = rays.first(hits.size());
+    }
+
+    auto castRange = [this, rays, hits](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            hits[i] = raycast(rays[i].origin, rays[i].direction, rays[i].tMax);
+    };
+
+    if (threadCount <= 1 || rays.size() <= RAYCAST_BATCH_SIZE) {
+        castRange(0, rays.size());
+        return;
+    }
+
+    // The tree is only read, so every batch can run on its own worker
+    ThreadPool pool(threadCount);
+    for (size_t begin = 0; begin < rays.size(); begin += RAYCAST_BATCH_SIZE) {
+        size_t end = std::min(begin + RAYCAST_BATCH_SIZE, rays.size());
+        pool.submit([castRange, begin, end]() {
+            castRange(begin, end);
+        });
+    }
+    pool.wait();
+}
+
+bool Octree::raycastNode(ONode* node, glm::vec3 t0, glm::vec3 t1, uint32_t mirrorMask, const Ray& ray, Hit& hit) {
+    // Parametric traversal (Revelles et al. 2000). t0 and t1 are the ray
+    // parameters where it crosses the node's lower and upper planes
+    float tEnter = glm::compMax(t0);
+    float tExit = glm::compMin(t1);
+    if (tExit < 0.0f || tEnter > ray.tMax)
+        return false;
+
+    const uint32_t axisOctantBits[3] = {1, 4, 2};
+    if (node->children.size() == 0) {
+        // Is leaf. The face normal comes from the last plane the ray entered through
+        uint32_t entryAxis = 0;
+        if (t0[1] > t0[entryAxis]) entryAxis = 1;
+        if (t0[2] > t0[entryAxis]) entryAxis = 2;
+
+        hit.leaf = node;
+        hit.t = std::max(tEnter, 0.0f);
+        hit.normal = glm::vec3(0.0f);
+        hit.normal[entryAxis] = ray.direction[entryAxis] > 0.0f ? -1.0f : 1.0f;
+        return true;
+    }
+
+    AABB nodeAABB = node->getVoxel().aabb;
+    ONode* octantChildren[8] = {nullptr};
+    for (ONode* child : node->children)
+        octantChildren[getAABBChildOctant(nodeAABB, child->getVoxel().aabb)] = child;
+
+    // The first child is on the upper side of every midplane crossed before entering the node
+    glm::vec3 tm = 0.5f * (t0 + t1);
+    uint32_t octant = 0;
+    for (uint32_t axis = 0; axis < 3; axis++)
+        if (tm[axis] < tEnter)
+            octant |= axisOctantBits[axis];
+
+    while (true) {
+        glm::vec3 childT0, childT1;
+        for (uint32_t axis = 0; axis < 3; axis++) {
+            bool upper = octant & axisOctantBits[axis];
+            childT0[axis] = upper ? tm[axis] : t0[axis];
+            childT1[axis] = upper ? t1[axis] : tm[axis];
+        }
+
+        ONode* child = octantChildren[octant ^ mirrorMask];
+        if (child != nullptr && raycastNode(child, childT0, childT1, mirrorMask, ray, hit))
+            return true;
+
+        // Step to the neighbor across the plane the ray leaves the child through
+        uint32_t exitAxis = 0;
+        if (childT1[1] < childT1[exitAxis]) exitAxis = 1;
+        if (childT1[2] < childT1[exitAxis]) exitAxis = 2;
+        if ((octant & axisOctantBits[exitAxis]) || childT1[exitAxis] > ray.tMax)
+            return false;
+        octant |= axisOctantBits[exitAxis];
+    }
+}
+
+void Octree::raycastPackets(std::span<const Ray> rays, std::span<Hit> hits, uint32_t packetWidth, uint32_t threadCount) {
+    if (hits.size() < rays.size()) {
+        spdlog::warn("Raycast hit buffer is smaller than the ray batch. Extra rays are ignored.");
+        rays = rays.first(hits.size());
+    }
+
+    if (packetWidth > RAY_PACKET_MAX_WIDTH) {
+        spdlog::warn(std::to_string(packetWidth) + " wide ray packets are not available in this build. Using " + std::to_string(RAY_PACKET_MAX_WIDTH) + " wide packets.");
+        packetWidth = RAY_PACKET_MAX_WIDTH;
+    }
+
+    // Scalar fallback
+    if (packetWidth < 4 || isEmpty()) {
+        raycast(rays, hits, threadCount);
+        return;
+    }
+
+    auto castRange = [this, rays, hits, packetWidth](size_t begin, size_t end) {
+#if defined(__AVX2__)
+        if (packetWidth == 8) {
+            raycastPacketRange<AVX2Lanes>(rays, hits, begin, end);
+            return;
+        }
+#endif
+#if defined(__SSE2__)
+        raycastPacketRange<SSELanes>(rays, hits, begin, end);
+#endif
+    };
+
+    if (threadCount <= 1 || rays.size() <= RAYCAST_BATCH_SIZE) {
+        castRange(0, rays.size());
+        return;
+    }
+
+    // Batches are a multiple of every packet width, so packets never straddle two tasks
+    ThreadPool pool(threadCount);
+    for (size_t begin = 0; begin < rays.size(); begin += RAYCAST_BATCH_SIZE) {
+        size_t end = std::min(begin + RAYCAST_BATCH_SIZE, rays.size());
+        pool.submit([castRange, begin, end]() {
+            castRange(begin, end);
+        });
+    }
+    pool.wait();
+}
+
+template<typename Lanes>
+void Octree::raycastPacketRange(std::span<const Ray> rays, std::span<Hit> hits, size_t begin, size_t end) {
+    AABB rootAABB = root->getVoxel().aabb;
+    const uint32_t axisOctantBits[3] = {1, 4, 2};
+
+    for (size_t first = begin; first < end; first += Lanes::width) {
+        uint32_t rayCount = std::min<size_t>(Lanes::width, end - first);
+
+        // Consecutive rays are packed together, then split by direction octant
+        // so every packet walks the children in a single front to back order
+        uint32_t rayMirrorMasks[RAY_PACKET_MAX_WIDTH];
+        uint32_t pendingMask = 0;
+        for (uint32_t lane = 0; lane < rayCount; lane++) {
+            const Ray& ray = rays[first + lane];
+            rayMirrorMasks[lane] = 0;
+            for (uint32_t axis = 0; axis < 3; axis++)
+                if (ray.direction[axis] < 0.0f)
+                    rayMirrorMasks[lane] |= axisOctantBits[axis];
+
+            hits[first + lane] = {
+                .leaf = nullptr,
+                .t = ray.tMax,
+                .normal = glm::vec3(0.0f)
+            };
+            pendingMask |= 1 << lane;
+        }
+
+        while (pendingMask != 0) {
+            RayPacket packet;
+            packet.mirrorMask = rayMirrorMasks[std::countr_zero(pendingMask)];
+            for (uint32_t axis = 0; axis < 3; axis++) {
+                packet.originMin[axis] = packet.inverseMin[axis] = std::numeric_limits<float>::max();
+                packet.originMax[axis] = packet.inverseMax[axis] = std::numeric_limits<float>::lowest();
+            }
+
+            uint32_t activeMask = 0;
+            for (uint32_t lane = 0; lane < Lanes::width; lane++) {
+                // Rays of other octants stay as inactive lanes until their own packet
+                if (lane >= rayCount || !(pendingMask & (1 << lane)) || rayMirrorMasks[lane] != packet.mirrorMask) {
+                    packet.originX[lane] = packet.originY[lane] = packet.originZ[lane] = 0.0f;
+                    packet.inverseX[lane] = packet.inverseY[lane] = packet.inverseZ[lane] = 1.0f;
+                    packet.tMax[lane] = -1.0f;
+                    packet.rayIndices[lane] = 0;
+                    continue;
                 }
+
+                const Ray& ray = rays[first + lane];
+                glm::vec3 inverse;
+                for (uint32_t axis = 0; axis < 3; axis++) {
+                    // Parallel rays get a huge but finite slope, as in the scalar traversal
+                    float direction = ray.direction[axis];
+                    if (direction == 0.0f) direction = 1e-30f;
+                    inverse[axis] = 1.0f / direction;
+
+                    packet.originMin[axis] = std::min(packet.originMin[axis], ray.origin[axis]);
+                    packet.originMax[axis] = std::max(packet.originMax[axis], ray.origin[axis]);
+                    packet.inverseMin[axis] = std::min(packet.inverseMin[axis], inverse[axis]);
+                    packet.inverseMax[axis] = std::max(packet.inverseMax[axis], inverse[axis]);
+                }
+
+                packet.originX[lane] = ray.origin.x;
+                packet.originY[lane] = ray.origin.y;
+                packet.originZ[lane] = ray.origin.z;
+                packet.inverseX[lane] = inverse.x;
+                packet.inverseY[lane] = inverse.y;
+                packet.inverseZ[lane] = inverse.z;
+                packet.tMax[lane] = ray.tMax;
+                packet.rayIndices[lane] = first + lane;
+                activeMask |= 1 << lane;
             }
+            pendingMask &= ~activeMask;
+
+            raycastPacketNode<Lanes>(root, rootAABB, packet, activeMask, rays, hits);
+        }
+    }
+}
+
+template<typename Lanes>
+uint32_t Octree::raycastPacketNode(ONode* node, AABB nodeAABB, const RayPacket& packet, uint32_t activeMask, std::span<const Ray> rays, std::span<Hit> hits) {
+    if (isPacketMissingAABB(packet, nodeAABB))
+        return activeMask;
+
+    // Slab test for every lane at once
+    typename Lanes::Float originX = Lanes::load(packet.originX);
+    typename Lanes::Float originY = Lanes::load(packet.originY);
+    typename Lanes::Float originZ = Lanes::load(packet.originZ);
+    typename Lanes::Float inverseX = Lanes::load(packet.inverseX);
+    typename Lanes::Float inverseY = Lanes::load(packet.inverseY);
+    typename Lanes::Float inverseZ = Lanes::load(packet.inverseZ);
+
+    typename Lanes::Float tx0 = Lanes::mul(Lanes::sub(Lanes::set(nodeAABB.min.x), originX), inverseX);
+    typename Lanes::Float tx1 = Lanes::mul(Lanes::sub(Lanes::set(nodeAABB.max.x), originX), inverseX);
+    typename Lanes::Float ty0 = Lanes::mul(Lanes::sub(Lanes::set(nodeAABB.min.y), originY), inverseY);
+    typename Lanes::Float ty1 = Lanes::mul(Lanes::sub(Lanes::set(nodeAABB.max.y), originY), inverseY);
+    typename Lanes::Float tz0 = Lanes::mul(Lanes::sub(Lanes::set(nodeAABB.min.z), originZ), inverseZ);
+    typename Lanes::Float tz1 = Lanes::mul(Lanes::sub(Lanes::set(nodeAABB.max.z), originZ), inverseZ);
+
+    typename Lanes::Float nearX = Lanes::min(tx0, tx1), farX = Lanes::max(tx0, tx1);
+    typename Lanes::Float nearY = Lanes::min(ty0, ty1), farY = Lanes::max(ty0, ty1);
+    typename Lanes::Float nearZ = Lanes::min(tz0, tz1), farZ = Lanes::max(tz0, tz1);
+    typename Lanes::Float tEnter = Lanes::max(Lanes::max(nearX, nearY), nearZ);
+    typename Lanes::Float tExit = Lanes::min(Lanes::min(farX, farY), farZ);
+
+    uint32_t hitMask = activeMask &
+        Lanes::lessEqual(tEnter, tExit) &
+        Lanes::lessEqual(Lanes::set(0.0f), tExit) &
+        Lanes::lessEqual(tEnter, Lanes::load(packet.tMax));
+    if (hitMask == 0)
+        return activeMask;
+
+    bool isLeaf = node->children.size() == 0;
+    if (isLeaf || (uint32_t)std::popcount(hitMask) <= RAY_PACKET_SPLIT_THRESHOLD) {
+        alignas(32) float near[3][RAY_PACKET_MAX_WIDTH];
+        alignas(32) float far[3][RAY_PACKET_MAX_WIDTH];
+        Lanes::store(near[0], nearX);
+        Lanes::store(near[1], nearY);
+        Lanes::store(near[2], nearZ);
+        Lanes::store(far[0], farX);
+        Lanes::store(far[1], farY);
+        Lanes::store(far[2], farZ);
+
+        // Leaves finish every ray that reached them. Inner nodes with too few rays
+        // left hand each one to the scalar traversal for the rest of the subtree
+        uint32_t remainingMask = hitMask;
+        for (uint32_t lanes = hitMask; lanes != 0; lanes &= lanes - 1) {
+            uint32_t lane = std::countr_zero(lanes);
+            uint32_t rayIndex = packet.rayIndices[lane];
+            glm::vec3 t0 = glm::vec3(near[0][lane], near[1][lane], near[2][lane]);
+            glm::vec3 t1 = glm::vec3(far[0][lane], far[1][lane], far[2][lane]);
+            if (raycastNode(node, t0, t1, packet.mirrorMask, rays[rayIndex], hits[rayIndex]))
+                remainingMask &= ~(1 << lane);
+        }
+        return (activeMask & ~hitMask) | remainingMask;
+    }
+
+    ONode* octantChildren[8] = {nullptr};
+    for (ONode* child : node->children)
+        octantChildren[getAABBChildOctant(nodeAABB, child->getVoxel().aabb)] = child;
+
+    // Mirrored octants in increasing order are front to back for every ray of the
+    // packet, since a ray only ever crosses into octants with more bits set
+    uint32_t remainingMask = hitMask;
+    for (uint32_t octant = 0; octant < 8 && remainingMask != 0; octant++) {
+        uint32_t childOctant = octant ^ packet.mirrorMask;
+        ONode* child = octantChildren[childOctant];
+        if (child != nullptr)
+            remainingMask = raycastPacketNode<Lanes>(child, getAABBChild(nodeAABB, childOctant), packet, remainingMask, rays, hits);
+    }
+    return (activeMask & ~hitMask) | remainingMask;
+}
+
+bool Octree::isPacketMissingAABB(const RayPacket& packet, AABB aabb) {
+    // Interval arithmetic over the packet's origin and inverse direction bounds.
+    // If even the earliest possible entry is after the latest possible exit,
+    // no ray of the packet can hit the box
+    float enterLower = 0.0f;
+    float exitUpper = std::numeric_limits<float>::max();
+    for (uint32_t axis = 0; axis < 3; axis++) {
+        float planes[2] = {aabb.min[axis], aabb.max[axis]};
+        float planeLower[2], planeUpper[2];
+        for (uint32_t i = 0; i < 2; i++) {
+            float products[4] = {
+                (planes[i] - packet.originMax[axis]) * packet.inverseMin[axis],
+                (planes[i] - packet.originMax[axis]) * packet.inverseMax[axis],
+                (planes[i] - packet.originMin[axis]) * packet.inverseMin[axis],
+                (planes[i] - packet.originMin[axis]) * packet.inverseMax[axis]
+            };
+            planeLower[i] = std::min(std::min(products[0], products[1]), std::min(products[2], products[3]));
+            planeUpper[i] = std::max(std::max(products[0], products[1]), std::max(products[2], products[3]));
+        }
+
+        // Every lane shares the direction sign, so the near plane is the same for all
+        uint32_t nearPlane = packet.inverseMin[axis] < 0.0f ? 1 : 0;
+        enterLower = std::max(enterLower, planeLower[nearPlane]);
+        exitUpper = std::min(exitUpper, planeUpper[1 - nearPlane]);
+    }
+    return enterLower > exitUpper;
 }
 
 Mesh* Octree::compressToMesh(uint32_t depth) {
-    std::vector<Vertex> vertices;
-    std::vector<uint32_t> indices;
-    std::vector<Material> materials;
-    traverseGettingLeaves(root, 1, depth, vertices, indices);
+    std::vector<VoxelVertex> vertices;
+    if (!isEmpty())
+        traverseGettingLeaves(root, root->getVoxel().aabb, 1, depth, vertices);
 
+    // Points are drawn in order, no index buffer
     Mesh* volumeRenderMesh = new Mesh();
-    volumeRenderMesh->setVertices(vertices);
-    volumeRenderMesh->setIndices(indices);
+    volumeRenderMesh->setVoxelVertices(vertices, depth);
     return volumeRenderMesh;
 }
 
-void Octree::traverseGettingLeaves(ONode* node, uint32_t depth, uint32_t maxTraverseDepth, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+void Octree::traverseGettingLeaves(ONode* node, AABB rootAABB, uint32_t depth, uint32_t maxTraverseDepth, std::vector<VoxelVertex>& vertices) {
     if (depth > maxTraverseDepth || depth > maxDepth)
         return;
 
     if (node->children.size() == 0) {
         // Is leaf
         Voxel voxel = node->getVoxel();
-
-        uint32_t voxelColor = voxel.renderData;
-        glm::vec3 color = glm::vec3((voxelColor & 0x00110000) >> 16, (voxelColor & 0x00001100) >> 8, voxelColor & 0x0000011);        
-
-        Vertex v = {
-            .position = voxel.aabb.center,
-            .normal = voxel.normal,
-            .color = color
-        };
-        vertices.push_back(v);
-        indices.push_back(indices.size());
+        vertices.push_back(VoxelVertex::pack(getVoxelCell(rootAABB, maxTraverseDepth, voxel.aabb.center), voxel.normal, voxel.renderData));
         return;
     }
     
     for (ONode* child : node->children)
-        traverseGettingLeaves(child, depth + 1, maxTraverseDepth, vertices, indices);
+        traverseGettingLeaves(child, rootAABB, depth + 1, maxTraverseDepth, vertices);
 }
 
 std::vector<Mesh*> Octree::getDebugMeshes() {
     std::vector<Mesh*> meshes;
-    traverseGettingMeshes(root, 1, meshes);
+    if (!isEmpty())
+        traverseGettingMeshes(root, 1, meshes);
     return meshes;
 }
 
@@ -126,13 +741,101 @@ void Octree::traverseGettingMeshes(ONode* node, uint32_t depth, std::vector<Mesh
         traverseGettingMeshes(child, depth + 1, meshes);
 }
 
-glm::vec3 Octree::getVoxelDataAverageNormal(std::vector<Voxel> data) {
-    glm::vec3 averageNormal = glm::vec3(0.0f);
-    for (Voxel v : data)
-        averageNormal += v.normal;
-    return glm::normalize(averageNormal);
+void Octree::accumulateVoxelData(ONode* node, const std::vector<Voxel>& data) {
+    for (const auto& voxel : data) {
+        node->voxelCount++;
+        node->normalSum += voxel.normal;
+        node->colorSum += unpackVoxelColor(voxel.renderData);
+    }
+    refreshNodeVoxel(node);
+}
+
+void Octree::refreshNodeVoxel(ONode* node) {
+    // Average normal and color from the running totals
+    Voxel nodeVoxel = node->getVoxel();
+    // Opposite normals can cancel out, those nodes keep the zero sum
+    nodeVoxel.normal = glm::length(node->normalSum) > 0.0f ? glm::normalize(node->normalSum) : node->normalSum;
+    nodeVoxel.renderData = node->voxelCount > 0 ? packVoxelColor(node->colorSum / (float)node->voxelCount) : 0;
+    node->setVoxel(nodeVoxel);
+}
+
+AABB Octree::getVoxelDataBounds(const std::vector<Voxel>& data) {
+    return getVoxelBounds(data);
 }
 
 ONode* Octree::getRoot() {
     return root;
 }
+
+bool Octree::isEmpty() {
+    // Erasing every voxel leaves a root without children or voxels
+    return root == nullptr || root->voxelCount == 0;
+}
+
+uint32_t Octree::getMaxDepth() {
+    return maxDepth;
+}
+
+size_t Octree::getMemoryUsage() {
+    return getAllocationStats().usedBytes;
+}
+
+OctreeAllocationStats Octree::getAllocationStats() {
+    OctreeAllocationStats stats = {0, 0, 0, 0, 0};
+    for (NodeArena* arena : arenas) {
+        stats.nodeCount += arena->getNodeCount();
+        stats.childListCount += arena->getChildListCount();
+        stats.blockCount += arena->getBlockCount();
+        stats.reservedBytes += arena->getReservedBytes();
+        stats.usedBytes += arena->getUsedBytes();
+    }
+    return stats;
+}
+
+ONode* Octree::findChild(ONode* node, uint32_t octant, uint32_t& slot) {
+    AABB nodeAABB = node->getVoxel().aabb;
+    for (slot = 0; slot < node->children.size(); slot++)
+        if (getAABBChildOctant(nodeAABB, node->children[slot]->getVoxel().aabb) == octant)
+            return node->children[slot];
+    return nullptr;
+}
+
+void Octree::insertChild(ONode* node, ONode* child, uint32_t octant) {
+    // Child lists are sized exactly, so a new one is taken from the arena keeping the octant order
+    AABB nodeAABB = node->getVoxel().aabb;
+    uint32_t childCount = node->children.size();
+    ONode** children = arenas[0]->allocateChildren(childCount + 1);
+
+    uint32_t slot = 0;
+    while (slot < childCount && getAABBChildOctant(nodeAABB, node->children[slot]->getVoxel().aabb) < octant) {
+        children[slot] = node->children[slot];
+        slot++;
+    }
+    children[slot] = child;
+    for (uint32_t i = slot; i < childCount; i++)
+        children[i + 1] = node->children[i];
+
+    node->setChildren(children, childCount + 1);
+}
+
+void Octree::removeChild(ONode* node, uint32_t slot) {
+    ONode** children = node->children.nodes;
+    uint32_t childCount = node->children.size();
+    for (uint32_t i = slot; i + 1 < childCount; i++)
+        children[i] = children[i + 1];
+    node->setChildren(children, childCount - 1);
+}
+
+void Octree::resetArenas(uint32_t arenaCount) {
+    for (NodeArena* arena : arenas)
+        delete arena;
+    arenas.clear();
+    root = nullptr;
+
+    for (uint32_t i = 0; i < arenaCount; i++)
+        arenas.push_back(new NodeArena());
+}
+
+NodeArena* Octree::getBuildArena() {
+    return buildPool == nullptr ? arenas[0] : arenas[buildPool->getWorkerIndex()];
+}
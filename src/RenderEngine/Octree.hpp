@@ -1,34 +1,93 @@
 #ifndef _OCTREE_HPP_
 #define _OCTREE_HPP_
 
-#define LENGTH_EPSILON 1e-3
+// Nodes above this depth hand their children to the build thread pool
+#define PARALLEL_BUILD_DEPTH 4
+// Rays handed to each thread pool task by the batched raycast
+#define RAYCAST_BATCH_SIZE 1024
+// Packets down to this many active rays finish the subtree ray by ray
+#define RAY_PACKET_SPLIT_THRESHOLD 1
 
 #include <algorithm>
 #include <vector>
 #include <limits>
+#include <span>
+#include <unordered_set>
+#include <bit>
 #include <glm/gtx/string_cast.hpp>
+#include <glm/gtx/component_wise.hpp>
 
 #include "ONode.hpp"
+#include "NodeArena.hpp"
+#include "Morton.hpp"
+#include "VoxelPyramid.hpp"
+#include "ThreadPool.hpp"
+#include "RayPacket.hpp"
 #include "Utils.hpp"
 #include "Geometry.hpp"
 
+struct OctreeAllocationStats {
+    size_t nodeCount;
+    size_t childListCount;
+    size_t blockCount;
+    size_t reservedBytes;
+    size_t usedBytes;
+};
+
+// Leaf touched by an edit. node is nullptr when the leaf was erased
+struct OctreeDirtyLeaf {
+    AABB aabb;
+    ONode* node;
+};
+
+// First leaf hit by a ray. leaf is nullptr on a miss
+struct Hit {
+    ONode* leaf;
+    float t;
+    glm::vec3 normal;
+};
+
 class Octree {
 public:
     Octree();
     ~Octree();
 
-    void build(std::vector<Voxel> data, uint32_t maxDepth);
+    void build(std::vector<Voxel> data, uint32_t maxDepth, uint32_t threadCount = 1);
+    void buildMorton(const std::vector<Voxel>& data, uint32_t maxDepth);
+    void buildFromPyramid(VoxelPyramid& pyramid, uint32_t maxDepth);
+    std::vector<OctreeDirtyLeaf> insert(std::span<const Voxel> voxels);
+    std::vector<OctreeDirtyLeaf> erase(std::span<const glm::vec3> positions);
+    Hit raycast(glm::vec3 origin, glm::vec3 direction, float tMax);
+    void raycast(std::span<const Ray> rays, std::span<Hit> hits, uint32_t threadCount = 1);
+    void raycastPackets(std::span<const Ray> rays, std::span<Hit> hits, uint32_t packetWidth = RAY_PACKET_MAX_WIDTH, uint32_t threadCount = 1);
     Mesh* compressToMesh(uint32_t depth);
     std::vector<Mesh*> getDebugMeshes();
     ONode* getRoot();
+    bool isEmpty();
+    uint32_t getMaxDepth();
+    size_t getMemoryUsage();
+    OctreeAllocationStats getAllocationStats();
 private:
     ONode* root;
     uint32_t maxDepth;
+    ThreadPool* buildPool;
+    std::vector<NodeArena*> arenas;
 
     void subdivideNode(ONode* node, std::vector<Voxel> data, uint32_t depth);
+    ONode* findChild(ONode* node, uint32_t octant, uint32_t& slot);
+    void insertChild(ONode* node, ONode* child, uint32_t octant);
+    void removeChild(ONode* node, uint32_t slot);
+    void resetArenas(uint32_t arenaCount);
+    NodeArena* getBuildArena();
+    bool raycastNode(ONode* node, glm::vec3 t0, glm::vec3 t1, uint32_t mirrorMask, const Ray& ray, Hit& hit);
+    template<typename Lanes> void raycastPacketRange(std::span<const Ray> rays, std::span<Hit> hits, size_t begin, size_t end);
+    template<typename Lanes> uint32_t raycastPacketNode(ONode* node, AABB nodeAABB, const RayPacket& packet, uint32_t activeMask, std::span<const Ray> rays, std::span<Hit> hits);
+    bool isPacketMissingAABB(const RayPacket& packet, AABB aabb);
     void traverseGettingMeshes(ONode* node, uint32_t depth, std::vector<Mesh*>& meshes);
-    void traverseGettingLeaves(ONode* node, uint32_t depth, uint32_t maxTraverseDepth, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices); 
-    glm::vec3 getVoxelDataAverageNormal(std::vector<Voxel> data);
+    void traverseGettingLeaves(ONode* node, AABB rootAABB, uint32_t depth, uint32_t maxTraverseDepth, std::vector<VoxelVertex>& vertices); 
+    void accumulateVoxelData(ONode* node, const std::vector<Voxel>& data);
+    void refreshNodeVoxel(ONode* node);
+    AABB getVoxelDataBounds(const std::vector<Voxel>& data);
 };
 
 #endif
@@ -0,0 +1,81 @@
+#ifndef _RAY_PACKET_HPP_
+#define _RAY_PACKET_HPP_
+
+#include <stdint.h>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Widest packet built in, the traversal falls back to it when asked for more
+#if defined(__AVX2__)
+#define RAY_PACKET_MAX_WIDTH 8
+#elif defined(__SSE2__)
+#define RAY_PACKET_MAX_WIDTH 4
+#else
+#define RAY_PACKET_MAX_WIDTH 1
+#endif
+
+/*
+    RAY PACKET LANES
+    Thin wrappers over the SIMD registers used by the packet traversal. Every
+    variant exposes the same operations, comparisons return one bit per lane.
+*/
+#if defined(__SSE2__)
+struct SSELanes {
+    static constexpr uint32_t width = 4;
+    typedef __m128 Float;
+
+    static Float load(const float* values) { return _mm_loadu_ps(values); }
+    static Float set(float value) { return _mm_set1_ps(value); }
+    static void store(float* values, Float a) { _mm_storeu_ps(values, a); }
+    static Float sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+    static Float mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+    static Float min(Float a, Float b) { return _mm_min_ps(a, b); }
+    static Float max(Float a, Float b) { return _mm_max_ps(a, b); }
+    static uint32_t lessEqual(Float a, Float b) { return _mm_movemask_ps(_mm_cmple_ps(a, b)); }
+};
+#endif
+
+#if defined(__AVX2__)
+struct AVX2Lanes {
+    static constexpr uint32_t width = 8;
+    typedef __m256 Float;
+
+    static Float load(const float* values) { return _mm256_loadu_ps(values); }
+    static Float set(float value) { return _mm256_set1_ps(value); }
+    static void store(float* values, Float a) { _mm256_storeu_ps(values, a); }
+    static Float sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+    static Float mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+    static Float min(Float a, Float b) { return _mm256_min_ps(a, b); }
+    static Float max(Float a, Float b) { return _mm256_max_ps(a, b); }
+    static uint32_t lessEqual(Float a, Float b) { return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LE_OQ)); }
+};
+#endif
+
+/*
+    RAY PACKET
+    Rays in structure of arrays layout, one lane per ray. All the active rays
+    of a packet point into the same octant (mirrorMask), so they share one
+    front to back child order. The packet bounds feed the interval frustum
+    test that rejects whole nodes before any per ray work.
+*/
+struct RayPacket {
+    alignas(32) float originX[RAY_PACKET_MAX_WIDTH];
+    alignas(32) float originY[RAY_PACKET_MAX_WIDTH];
+    alignas(32) float originZ[RAY_PACKET_MAX_WIDTH];
+    alignas(32) float inverseX[RAY_PACKET_MAX_WIDTH];
+    alignas(32) float inverseY[RAY_PACKET_MAX_WIDTH];
+    alignas(32) float inverseZ[RAY_PACKET_MAX_WIDTH];
+    alignas(32) float tMax[RAY_PACKET_MAX_WIDTH];
+
+    uint32_t rayIndices[RAY_PACKET_MAX_WIDTH];
+    uint32_t mirrorMask;
+
+    float originMin[3];
+    float originMax[3];
+    float inverseMin[3];
+    float inverseMax[3];
+};
+
+#endif
@@ -24,17 +24,29 @@ RenderEngine::RenderEngine() {
     texturePool = new TexturePool();
     texturePool->requireTexture(vulkan.device, vulkan.commandPool, "assets/textures/default.png");
 
+    // Initialize the on-disk cache of voxelized OBJ files
+    volumeCache = new VolumeCache("assets/cache", VOLUME_CACHE_DEFAULT_MAX_BYTES);
+
     // Initialize the UIStates
     uiStates.showCameraProperties = false;
     uiStates.showDebugStructures = false;
     uiStates.octreeTargetDepth = 5;
+    uiStates.useMortonOctreeBuilder = true;
+    uiStates.octreeBuildThreads = ThreadPool::getHardwareThreadCount();
+    uiStates.useVoxelDAG = false;
+    uiStates.streamVoxelization = false;
+    uiStates.cacheVoxelization = true;
+    uiStates.useVoxelCubeInstancing = false;
 
     // Initialize time data
     deltaTime = 0.0;
     lastTime = 0.0;
+    voxelPipelineBenchmarkFrame = -1;
 
     // Initialize octree
     targetOctree = nullptr;
+    targetLinearOctree = nullptr;
+    targetVoxelDAG = nullptr;
 
     #ifndef NDEBUG
         spdlog::info("Render engine successfully initialized");
@@ -44,10 +56,16 @@ RenderEngine::RenderEngine() {
 RenderEngine::~RenderEngine() {
     // Destroy the scene
     clearScene();
+    delete volumeCache;
 
     // Default pipeline destruction
     deletePipeline(render.defaultPipeline);
 
+    // Instanced voxel cube pipeline destruction
+    deletePipeline(render.voxelCubePipeline);
+    vulkan.device->freeDeviceMemory(render.voxelCubeIndexBuffer->getDeviceMemory());
+    delete render.voxelCubeIndexBuffer;
+
     // Terminate ImGui
     ImGui::DestroyContext();
 
@@ -230,9 +248,13 @@ void RenderEngine::initVulkan() {
     render.defaultShaders.push_back(new ShaderModule(vulkan.device, Utils::loadShaderCode("assets/shaders/default.frag.spv"), vk::ShaderStageFlagBits::eFragment, 64, 32));
 
     // Voxel shaders initialization
-    render.voxelShaders.push_back(new ShaderModule(vulkan.device, Utils::loadShaderCode("assets/shaders/voxel.geom.spv"), vk::ShaderStageFlagBits::eGeometry, 0, 80));
+    render.voxelShaders.push_back(new ShaderModule(vulkan.device, Utils::loadShaderCode("assets/shaders/voxel.geom.spv"), vk::ShaderStageFlagBits::eGeometry, 0, 96));
     render.voxelShaders.push_back(new ShaderModule(vulkan.device, Utils::loadShaderCode("assets/shaders/voxel.vert.spv"), vk::ShaderStageFlagBits::eVertex, 0, 0));
-    render.voxelShaders.push_back(new ShaderModule(vulkan.device, Utils::loadShaderCode("assets/shaders/voxel.frag.spv"), vk::ShaderStageFlagBits::eFragment, 80, 32));
+    render.voxelShaders.push_back(new ShaderModule(vulkan.device, Utils::loadShaderCode("assets/shaders/voxel.frag.spv"), vk::ShaderStageFlagBits::eFragment, 96, 32));
+
+    // Instanced voxel cube shaders initialization, the vertex stage takes over the geometry constants
+    render.voxelCubeShaders.push_back(new ShaderModule(vulkan.device, Utils::loadShaderCode("assets/shaders/voxelCube.vert.spv"), vk::ShaderStageFlagBits::eVertex, 0, 96));
+    render.voxelCubeShaders.push_back(new ShaderModule(vulkan.device, Utils::loadShaderCode("assets/shaders/voxel.frag.spv"), vk::ShaderStageFlagBits::eFragment, 96, 32));
 
     // Debug shaders initialization
     render.debugShaders.push_back(new ShaderModule(vulkan.device, Utils::loadShaderCode("assets/shaders/debug.vert.spv"), vk::ShaderStageFlagBits::eVertex, 0, 64));
@@ -253,13 +275,14 @@ void RenderEngine::initVulkan() {
         1.0f
     );
 
-    // Voxel pipeline initialization
+    // Voxel pipeline initialization, its points are packed voxel vertices
+    VertexInputDescription voxelVertexDescription = VoxelVertex::getVertexDescription();
     render.voxelPipeline = new Pipeline(
         vulkan.device,
         render.renderPass,
         render.voxelShaders,
-        vertexDescription.bindings,
-        vertexDescription.attributes,
+        voxelVertexDescription.bindings,
+        voxelVertexDescription.attributes,
         vk::PrimitiveTopology::ePointList,
         vk::PolygonMode::eFill,
         vulkan.viewport,
@@ -267,6 +290,39 @@ void RenderEngine::initVulkan() {
         1.0f
     );
 
+    // Instanced voxel cube pipeline initialization, one voxel vertex per instance
+    VertexInputDescription voxelCubeVertexDescription = VoxelVertex::getVertexDescription(vk::VertexInputRate::eInstance);
+    render.voxelCubePipeline = new Pipeline(
+        vulkan.device,
+        render.renderPass,
+        render.voxelCubeShaders,
+        voxelCubeVertexDescription.bindings,
+        voxelCubeVertexDescription.attributes,
+        vk::PrimitiveTopology::eTriangleList,
+        vk::PolygonMode::eFill,
+        vulkan.viewport,
+        vulkan.scissor,
+        1.0f
+    );
+
+    // Cube shared by every voxel instance. Corner c sits at (c & 1, c >> 1 & 1, c >> 2 & 1),
+    // and the triangles are those of the voxel.geom strip, wound the same way
+    std::array<uint32_t, VOXEL_CUBE_INDEX_COUNT> voxelCubeIndices = {
+        6, 7, 4, 4, 7, 5,
+        4, 5, 1, 1, 5, 7,
+        1, 7, 3, 3, 7, 6,
+        3, 6, 2, 2, 6, 4,
+        2, 4, 0, 0, 4, 1,
+        0, 1, 2, 2, 1, 3
+    };
+    render.voxelCubeIndexBuffer = new Buffer (
+        vulkan.device,
+        (void*)voxelCubeIndices.data(),
+        voxelCubeIndices.size() * sizeof(uint32_t),
+        vk::BufferUsageFlagBits::eIndexBuffer,
+        vk::MemoryPropertyFlagBits::eHostCoherent | vk::MemoryPropertyFlagBits::eHostVisible
+    );
+
     // Debug pipeline initialization
     render.debugPipeline = new Pipeline(
         vulkan.device,
@@ -488,6 +544,10 @@ void RenderEngine::renderFrame() {
     deltaTime = currentTime - lastTime;
     lastTime = currentTime;
 
+    // Pick the voxel pipeline of this frame while benchmarking them
+    if (voxelPipelineBenchmarkFrame >= 0)
+        updateVoxelPipelineBenchmark();
+
     // Calculate model view projection matrix
     glm::mat4 modelMatrix = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 0.0f)), glm::vec3(1.0f, 1.0f, 1.0f));
     glm::mat4 mvp = camera->getProjectionMatrix() * camera->getViewMatrix() * modelMatrix;
@@ -500,12 +560,14 @@ void RenderEngine::renderFrame() {
 
     // Get Octree information
     glm::vec4 octreeData = glm::vec4(0.0f);
-    if (targetOctree != nullptr) {
+    glm::vec4 octreeMin = glm::vec4(0.0f);
+    if (targetLinearOctree != nullptr) {
         float octreeDepth = (float)uiStates.octreeTargetDepth;
-        glm::vec4 octreeAABBMin = glm::vec4(targetOctree->getRoot()->getVoxel().aabb.min, 1.0f);
-        glm::vec4 octreeAABBMax = glm::vec4(targetOctree->getRoot()->getVoxel().aabb.max, 1.0f);
+        glm::vec4 octreeAABBMin = glm::vec4(targetLinearOctree->getBounds().min, 1.0f);
+        glm::vec4 octreeAABBMax = glm::vec4(targetLinearOctree->getBounds().max, 1.0f);
         octreeData = octreeAABBMax - octreeAABBMin;
         octreeData.w = octreeDepth;
+        octreeMin = octreeAABBMin;
     }
 
     // Start Imgui frame
@@ -613,39 +675,60 @@ void RenderEngine::renderFrame() {
         }
     }
 
-    // Bind volume pipeline
-    commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, render.voxelPipeline->getPipeline());
+    // Bind volume pipeline, voxels are expanded to cubes by the geometry shader or drawn as cube instances
+    bool voxelCubeInstancing = uiStates.useVoxelCubeInstancing;
+    Pipeline* voxelPipeline = voxelCubeInstancing ? render.voxelCubePipeline : render.voxelPipeline;
+    vk::ShaderStageFlagBits geometryStage = voxelCubeInstancing ? vk::ShaderStageFlagBits::eVertex : vk::ShaderStageFlagBits::eGeometry;
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, voxelPipeline->getPipeline());
 
-    // Push constants
+    // Push constants, the geometry ones are pushed per mesh below
     GeometryConstants geometryConstants = {
         .mvp = mvp,
-        .octreeData = octreeData
+        .octreeData = octreeData,
+        .octreeMin = octreeMin
     };
-    range = render.voxelPipeline->getPushConstantRange(vk::ShaderStageFlagBits::eGeometry);
+    range = voxelPipeline->getPushConstantRange(vk::ShaderStageFlagBits::eFragment);
     commandBuffer.pushConstants (
-        render.voxelPipeline->getPipelineLayout(),
-        vk::ShaderStageFlagBits::eGeometry,
-        0,
-        sizeof(geometryConstants),
-        &geometryConstants
-    );
-
-    range = render.voxelPipeline->getPushConstantRange(vk::ShaderStageFlagBits::eFragment);
-    commandBuffer.pushConstants (
-        render.voxelPipeline->getPipelineLayout(),
+        voxelPipeline->getPipelineLayout(),
         vk::ShaderStageFlagBits::eFragment,
-        80,
+        96,
         32,
         &fragmentConstants
     );
 
     for (Mesh* mesh : voxelScene) {
+        if (mesh->getVertexBuffer() == nullptr) continue;
+
+        // Cells are unpacked at the depth the mesh was generated at, not the slider depth, which
+        // only regenerates meshes that come from a pyramid
+        geometryConstants.octreeData.w = (float)mesh->getVoxelDepth();
+        commandBuffer.pushConstants (
+            voxelPipeline->getPipelineLayout(),
+            geometryStage,
+            0,
+            sizeof(geometryConstants),
+            &geometryConstants
+        );
+
         vk::DeviceSize offsets[]{0};
         vk::Buffer volumeVertexBuffer = mesh->getVertexBuffer()->getBuffer();
         commandBuffer.bindVertexBuffers(0, 1, &volumeVertexBuffer, offsets);
-        commandBuffer.bindIndexBuffer(mesh->getIndexBuffer()->getBuffer(), 0, vk::IndexType::eUint32);
+
+        // One instance of the shared cube per voxel vertex
+        if (voxelCubeInstancing) {
+            commandBuffer.bindIndexBuffer(render.voxelCubeIndexBuffer->getBuffer(), 0, vk::IndexType::eUint32);
+            commandBuffer.drawIndexed(VOXEL_CUBE_INDEX_COUNT, mesh->getNumVertices(), 0, 0, 0);
+            continue;
+        }
+
+        // Voxel points come without indices, one point per vertex
+        if (mesh->getIndexBuffer() == nullptr) {
+            commandBuffer.draw(mesh->getNumVertices(), 1, 0, 0);
+            continue;
+        }
 
         // Draw indexed
+        commandBuffer.bindIndexBuffer(mesh->getIndexBuffer()->getBuffer(), 0, vk::IndexType::eUint32);
         commandBuffer.drawIndexed(mesh->getNumIndices(), 1, 0, 0, 0);
     }
 
@@ -718,6 +801,87 @@ void RenderEngine::renderUI() {
                         addVoxelizedOBJToScene(file);
                 ImGui::EndMenu();
             }
+
+            if (ImGui::BeginMenu("Triangulate OBJ")) {
+                std::vector<std::string> objFiles = Utils::listFolderFiles("assets/objs");
+                for (const auto& file : objFiles)
+                    if (ImGui::MenuItem(file.c_str()))
+                        addTriangulatedOBJToScene(file);
+                ImGui::EndMenu();
+            }
+
+            if (ImGui::BeginMenu("Extract OBJ isosurface")) {
+                std::vector<std::string> objFiles = Utils::listFolderFiles("assets/objs");
+                for (const auto& file : objFiles)
+                    if (ImGui::MenuItem(file.c_str()))
+                        addIsoSurfaceToScene(file);
+                ImGui::EndMenu();
+            }
+
+            if (ImGui::BeginMenu("Load SVO")) {
+                std::vector<std::string> svoFiles = Utils::listFolderFiles("assets/svos");
+                for (const auto& file : svoFiles)
+                    if (ImGui::MenuItem(file.c_str()))
+                        addSVOToScene(file);
+                ImGui::EndMenu();
+            }
+
+            if (ImGui::MenuItem("Save SVO", nullptr, false, targetLinearOctree != nullptr))
+                saveTargetOctree();
+
+            if (ImGui::MenuItem("Benchmark SVO round trip", nullptr, false, targetLinearOctree != nullptr))
+                benchmarkSVORoundTrip();
+
+            if (ImGui::BeginMenu("Benchmark octree build")) {
+                std::vector<std::string> objFiles = Utils::listFolderFiles("assets/objs");
+                for (const auto& file : objFiles)
+                    if (ImGui::MenuItem(file.c_str()))
+                        benchmarkOctreeBuild(file);
+                ImGui::EndMenu();
+            }
+
+            if (ImGui::BeginMenu("Benchmark octree raycast")) {
+                std::vector<std::string> objFiles = Utils::listFolderFiles("assets/objs");
+                for (const auto& file : objFiles)
+                    if (ImGui::MenuItem(file.c_str()))
+                        benchmarkOctreeRaycast(file);
+                ImGui::EndMenu();
+            }
+
+            if (ImGui::BeginMenu("Benchmark voxelizer")) {
+                std::vector<std::string> objFiles = Utils::listFolderFiles("assets/objs");
+                for (const auto& file : objFiles)
+                    if (ImGui::MenuItem(file.c_str()))
+                        benchmarkVoxelizer(file);
+                ImGui::EndMenu();
+            }
+
+            if (ImGui::BeginMenu("Benchmark voxel scales")) {
+                std::vector<std::string> objFiles = Utils::listFolderFiles("assets/objs");
+                for (const auto& file : objFiles)
+                    if (ImGui::MenuItem(file.c_str()))
+                        benchmarkVoxelScales(file);
+                ImGui::EndMenu();
+            }
+
+            if (ImGui::BeginMenu("Benchmark volume meshing")) {
+                std::vector<std::string> objFiles = Utils::listFolderFiles("assets/objs");
+                for (const auto& file : objFiles)
+                    if (ImGui::MenuItem(file.c_str()))
+                        benchmarkVolumeMeshing(file);
+                ImGui::EndMenu();
+            }
+
+            if (ImGui::BeginMenu("Benchmark isosurface")) {
+                std::vector<std::string> objFiles = Utils::listFolderFiles("assets/objs");
+                for (const auto& file : objFiles)
+                    if (ImGui::MenuItem(file.c_str()))
+                        benchmarkIsoSurface(file);
+                ImGui::EndMenu();
+            }
+
+            if (ImGui::MenuItem("Benchmark voxel pipelines", nullptr, false, !voxelScene.empty() && voxelPipelineBenchmarkFrame < 0))
+                benchmarkVoxelPipelines();
             ImGui::EndMenu();
         }
 
@@ -726,7 +890,18 @@ void RenderEngine::renderUI() {
             ImGui::Checkbox("Show debug structures", &uiStates.showDebugStructures);
             ImGui::InputInt("Voxel scale", &Voxelizer::scale);
             ImGui::InputInt("Voxel density", &Voxelizer::density);
-            ImGui::SliderInt("Octree rendering depth", &uiStates.octreeTargetDepth, 1, 10); 
+            ImGui::InputInt("Sampling seed", &Voxelizer::seed);
+            ImGui::Combo("Voxelization mode", &Voxelizer::mode, "Sampling\0Conservative\0Solid\0Signed distance\0");
+            ImGui::InputInt("Voxelizer threads", &Voxelizer::threadCount);
+            ImGui::Checkbox("Stream OBJ voxelization", &uiStates.streamVoxelization);
+            ImGui::Checkbox("Cache voxelizations", &uiStates.cacheVoxelization);
+            ImGui::Combo("Volume meshing", &Voxelizer::meshing, "Cubes\0Culled faces\0Greedy\0");
+            if (ImGui::SliderInt("Octree rendering depth", &uiStates.octreeTargetDepth, 1, 10))
+                refreshVolumeMesh();
+            ImGui::Checkbox("Morton octree builder", &uiStates.useMortonOctreeBuilder);
+            ImGui::InputInt("Octree build threads", &uiStates.octreeBuildThreads);
+            ImGui::Checkbox("Voxel DAG compression", &uiStates.useVoxelDAG);
+            ImGui::Checkbox("Instanced voxel cubes", &uiStates.useVoxelCubeInstancing);
             ImGui::EndMenu();
         }
         
@@ -887,58 +1062,557 @@ void RenderEngine::addOBJToScene(std::string objPath) {
 
 void RenderEngine::addVoxelizedOBJToScene(std::string objPath) {
     // Clear octree if it exists
-    if (targetOctree != nullptr)
-        delete targetOctree;
+    clearTargetOctree();
+    targetVolumeName = std::filesystem::path(objPath).stem().string();
+
+    // Load model from obj path, voxelize it and add to the scene. Streaming reads
+    // the file in chunks instead, for models that do not fit in memory. Cached
+    // volumes of the same file and parameters skip both
+    Volume meshVolume;
+    uint64_t cacheKey;
+    bool cacheable = uiStates.cacheVoxelization && volumeCache->getKey(objPath, "assets/materials", uiStates.streamVoxelization, cacheKey);
+    if (!cacheable || !volumeCache->load(cacheKey, meshVolume)) {
+        if (uiStates.streamVoxelization)
+            meshVolume = Voxelizer::voxelizeOBJFile(objPath);
+        else {
+            Mesh* newMesh = Utils::loadOBJFile(objPath, "assets/materials");
+            meshVolume = Voxelizer::voxelizeMesh(newMesh, texturePool->getImageCache());
+            delete newMesh;
+        }
 
-    // Load model from obj path, voxelize it and add to the scene
-    Mesh* newMesh = Utils::loadOBJFile(objPath, "assets/materials");
-    Volume meshVolume = Voxelizer::voxelizeMesh(newMesh);
+        if (cacheable)
+            volumeCache->store(cacheKey, meshVolume);
+    }
+
+    // Every voxel already has its own cell at the deepest pyramid level, deeper trees add nothing
+    targetPyramid = meshVolume.pyramid;
+    if (targetPyramid != nullptr && targetPyramid->getMaxDepth() > 0)
+        uiStates.octreeTargetDepth = std::min(uiStates.octreeTargetDepth, (int)targetPyramid->getMaxDepth());
 
+    // The Morton builder links the pyramid levels into nodes, they are already sorted and summed
     targetOctree = new Octree();
-    targetOctree->build(meshVolume.voxels, uiStates.octreeTargetDepth);
-    addVolumeMeshToScene(targetOctree->compressToMesh(uiStates.octreeTargetDepth));
+    double buildStartTime = window->getTime();
+    if (uiStates.useMortonOctreeBuilder && targetPyramid != nullptr)
+        targetOctree->buildFromPyramid(*targetPyramid, uiStates.octreeTargetDepth);
+    else if (uiStates.useMortonOctreeBuilder)
+        targetOctree->buildMorton(meshVolume.voxels, uiStates.octreeTargetDepth);
+    else
+        targetOctree->build(meshVolume.voxels, uiStates.octreeTargetDepth, std::max(uiStates.octreeBuildThreads, 1));
+    double buildTime = (window->getTime() - buildStartTime) * 1000.0;
+    std::string builderName = uiStates.useMortonOctreeBuilder ? (targetPyramid != nullptr ? "Pyramid" : "Morton") : "Recursive (" + std::to_string(std::max(uiStates.octreeBuildThreads, 1)) + " threads)";
+    spdlog::info(builderName + " octree build took " + std::to_string(buildTime) + " ms for " + std::to_string(meshVolume.voxels.size()) + " voxels.");
+
+    OctreeAllocationStats allocationStats = targetOctree->getAllocationStats();
+    spdlog::info("Octree allocations: " + std::to_string(allocationStats.nodeCount) + " nodes and " + std::to_string(allocationStats.childListCount) + " child lists in " + std::to_string(allocationStats.blockCount) + " arena blocks (" + std::to_string(allocationStats.usedBytes) + " of " + std::to_string(allocationStats.reservedBytes) + " bytes used).");
+
+    // Flatten the tree into the pointerless layout the scene meshes are generated from
+    targetLinearOctree = new LinearOctree();
+    targetLinearOctree->build(targetOctree);
+
+    size_t nodeCount = targetLinearOctree->getNodeCount();
+    if (nodeCount > 0) {
+        size_t treeMemory = targetOctree->getMemoryUsage();
+        size_t linearMemory = targetLinearOctree->getMemoryUsage();
+        spdlog::info("Octree nodes: " + std::to_string(nodeCount) + ". ONode tree: " + std::to_string(treeMemory) + " bytes (" + std::to_string(treeMemory / nodeCount) + " B/node). Linear octree: " + std::to_string(linearMemory) + " bytes (" + std::to_string(linearMemory / nodeCount) + " B/node).");
+    }
+
+    if (!uiStates.useVoxelDAG) {
+        addVolumeMeshToScene(targetLinearOctree->compressToMesh(uiStates.octreeTargetDepth));
+        return;
+    }
 
-    // std::vector<Mesh*> debugOctreeMeshes = targetOctree->getDebugMeshes();
+    // Merge identical subtrees, the volume mesh is then extracted from the DAG
+    targetVoxelDAG = new VoxelDAG();
+    double dagStartTime = window->getTime();
+    targetVoxelDAG->build(targetOctree);
+    double dagTime = (window->getTime() - dagStartTime) * 1000.0;
+
+    DAGCompressionStats dagStats = targetVoxelDAG->getCompressionStats();
+    if (dagStats.dagNodeCount > 0) {
+        for (size_t level = 0; level < dagStats.levels.size(); level++) {
+            DAGLevelStats levelStats = dagStats.levels[level];
+            spdlog::info("DAG level " + std::to_string(level + 1) + ": " + std::to_string(levelStats.treeNodeCount) + " tree nodes -> " + std::to_string(levelStats.dagNodeCount) + " DAG nodes.");
+        }
+        double nodeRatio = (double)dagStats.treeNodeCount / dagStats.dagNodeCount;
+        double geometryRatio = (double)dagStats.treeGeometryBytes / dagStats.dagGeometryBytes;
+        spdlog::info("Voxel DAG built in " + std::to_string(dagTime) + " ms. Nodes: " + std::to_string(dagStats.treeNodeCount) + " -> " + std::to_string(dagStats.dagNodeCount) + " (" + std::to_string(nodeRatio) + "x). Geometry: " + std::to_string(dagStats.treeGeometryBytes) + " -> " + std::to_string(dagStats.dagGeometryBytes) + " bytes (" + std::to_string(geometryRatio) + "x). Leaf attributes: " + std::to_string(dagStats.attributeBytes) + " bytes.");
+    }
+
+    addVolumeMeshToScene(targetVoxelDAG->compressToMesh(uiStates.octreeTargetDepth));
+
+    // std::vector<Mesh*> debugOctreeMeshes = targetLinearOctree->getDebugMeshes();
     // for (Mesh* debugMesh : debugOctreeMeshes)
     //     addDebugMeshToScene(debugMesh); 
 }
 
+void RenderEngine::addTriangulatedOBJToScene(std::string objPath) {
+    // The volume surface is drawn as a regular mesh, in the current meshing mode
+    Mesh* newMesh = Utils::loadOBJFile(objPath, "assets/materials");
+    Volume meshVolume = Voxelizer::voxelizeMesh(newMesh, texturePool->getImageCache());
+    delete newMesh;
+    addMeshToScene(Voxelizer::triangulateVolume(meshVolume));
+}
+
+void RenderEngine::addIsoSurfaceToScene(std::string objPath) {
+    // Smooth with the signed distance mode, the other modes give the surface of their cells
+    Mesh* newMesh = Utils::loadOBJFile(objPath, "assets/materials");
+    Volume meshVolume = Voxelizer::voxelizeMesh(newMesh, texturePool->getImageCache());
+    delete newMesh;
+    addMeshToScene(IsoSurface::extract(meshVolume, Voxelizer::threadCount));
+}
+
+void RenderEngine::addSVOToScene(std::string svoPath) {
+    clearTargetOctree();
+    targetVolumeName = std::filesystem::path(svoPath).stem().string();
+
+    // Map the prebuilt octree, no ONode tree is rebuilt
+    targetLinearOctree = new LinearOctree();
+    double loadStartTime = window->getTime();
+    if (!targetLinearOctree->loadFromFile(svoPath)) {
+        delete targetLinearOctree;
+        targetLinearOctree = nullptr;
+        return;
+    }
+    double loadTime = (window->getTime() - loadStartTime) * 1000.0;
+
+    uiStates.octreeTargetDepth = targetLinearOctree->getMaxDepth();
+    double meshStartTime = window->getTime();
+    Mesh* volumeMesh = targetLinearOctree->compressToMesh(uiStates.octreeTargetDepth);
+    double meshTime = (window->getTime() - meshStartTime) * 1000.0;
+    spdlog::info("SVO with " + std::to_string(targetLinearOctree->getNodeCount()) + " nodes loaded in " + std::to_string(loadTime) + " ms, volume mesh generated in " + std::to_string(meshTime) + " ms.");
+
+    addVolumeMeshToScene(volumeMesh);
+}
+
+void RenderEngine::saveTargetOctree() {
+    if (targetLinearOctree == nullptr) return;
+
+    std::filesystem::create_directories("assets/svos");
+    targetLinearOctree->saveToFile("assets/svos/" + targetVolumeName + "_d" + std::to_string(targetLinearOctree->getMaxDepth()) + ".svo");
+}
+
+void RenderEngine::refreshVolumeMesh() {
+    // Any depth of a voxelized OBJ comes straight from its pyramid, no tree is rebuilt or traversed
+    if (targetPyramid == nullptr || targetPyramid->getMaxDepth() == 0) return;
+    uiStates.octreeTargetDepth = std::clamp(uiStates.octreeTargetDepth, 1, (int)targetPyramid->getMaxDepth());
+
+    double meshStartTime = window->getTime();
+    Mesh* volumeMesh = targetPyramid->compressToMesh(uiStates.octreeTargetDepth);
+    double meshTime = (window->getTime() - meshStartTime) * 1000.0;
+
+    for (Mesh* mesh : voxelScene)
+        deleteMesh(mesh);
+    voxelScene.clear();
+    addVolumeMeshToScene(volumeMesh);
+    spdlog::info("Volume mesh of depth " + std::to_string(uiStates.octreeTargetDepth) + " (" + std::to_string(targetPyramid->getLevel(uiStates.octreeTargetDepth).size()) + " voxels) generated from the pyramid in " + std::to_string(meshTime) + " ms.");
+}
+
+void RenderEngine::clearTargetOctree() {
+    targetPyramid = nullptr;
+    if (targetOctree != nullptr) {
+        double freeStartTime = window->getTime();
+        delete targetOctree;
+        spdlog::info("Octree freed in " + std::to_string((window->getTime() - freeStartTime) * 1000.0) + " ms.");
+        targetOctree = nullptr;
+    }
+
+    if (targetLinearOctree != nullptr) {
+        delete targetLinearOctree;
+        targetLinearOctree = nullptr;
+    }
+
+    if (targetVoxelDAG != nullptr) {
+        delete targetVoxelDAG;
+        targetVoxelDAG = nullptr;
+    }
+}
+
+void RenderEngine::benchmarkOctreeBuild(std::string objPath) {
+    // Voxelize once and time every builder configuration over the same volume
+    Mesh* mesh = Utils::loadOBJFile(objPath, "assets/materials");
+    Volume volume = Voxelizer::voxelizeMesh(mesh, texturePool->getImageCache());
+    delete mesh;
+
+    double baseTime = 0.0;
+    for (uint32_t threadCount : {1, 2, 4, 8, 16}) {
+        Octree* octree = new Octree();
+        double startTime = window->getTime();
+        octree->build(volume.voxels, uiStates.octreeTargetDepth, threadCount);
+        double buildTime = (window->getTime() - startTime) * 1000.0;
+        if (threadCount == 1) baseTime = buildTime;
+
+        startTime = window->getTime();
+        delete octree;
+        double freeTime = (window->getTime() - startTime) * 1000.0;
+        spdlog::info("Recursive octree build, " + std::to_string(threadCount) + " threads: " + std::to_string(buildTime) + " ms (" + std::to_string(baseTime / buildTime) + "x speedup), freed in " + std::to_string(freeTime) + " ms.");
+    }
+
+    Octree* mortonOctree = new Octree();
+    double startTime = window->getTime();
+    mortonOctree->buildMorton(volume.voxels, uiStates.octreeTargetDepth);
+    double buildTime = (window->getTime() - startTime) * 1000.0;
+
+    startTime = window->getTime();
+    delete mortonOctree;
+    double freeTime = (window->getTime() - startTime) * 1000.0;
+    spdlog::info("Morton octree build: " + std::to_string(buildTime) + " ms (" + std::to_string(baseTime / buildTime) + "x speedup), freed in " + std::to_string(freeTime) + " ms.");
+}
+
+void RenderEngine::benchmarkOctreeRaycast(std::string objPath) {
+    Mesh* mesh = Utils::loadOBJFile(objPath, "assets/materials");
+    Volume volume = Voxelizer::voxelizeMesh(mesh, texturePool->getImageCache());
+    delete mesh;
+
+    Octree* octree = new Octree();
+    octree->buildMorton(volume.voxels, uiStates.octreeTargetDepth);
+    if (octree->isEmpty()) {
+        delete octree;
+        return;
+    }
+
+    // Rays start on a sphere around the volume and aim at random points inside it.
+    // The seed is fixed so runs over the same model are comparable
+    AABB bounds = octree->getRoot()->getVoxel().aabb;
+    float radius = glm::length(bounds.max - bounds.min);
+    std::mt19937 generator(1234);
+    std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+
+    std::vector<Ray> rays(RAYCAST_BENCHMARK_RAY_COUNT);
+    for (Ray& ray : rays) {
+        glm::vec3 target = bounds.min + (bounds.max - bounds.min) * glm::vec3(distribution(generator), distribution(generator), distribution(generator));
+        glm::vec3 direction = glm::vec3(distribution(generator), distribution(generator), distribution(generator)) * 2.0f - 1.0f;
+        if (glm::length(direction) < LENGTH_EPSILON) direction = glm::vec3(0.0f, 0.0f, 1.0f);
+        direction = glm::normalize(direction);
+
+        ray.origin = bounds.center + direction * radius;
+        ray.direction = glm::normalize(target - ray.origin);
+        ray.tMax = 2.0f * radius;
+    }
+
+    std::vector<Hit> hits(rays.size());
+    double startTime = window->getTime();
+    for (size_t i = 0; i < rays.size(); i++)
+        hits[i] = octree->raycast(rays[i].origin, rays[i].direction, rays[i].tMax);
+    double singleTime = window->getTime() - startTime;
+
+    size_t hitCount = 0;
+    for (const Hit& hit : hits)
+        if (hit.leaf != nullptr) hitCount++;
+    spdlog::info("Octree raycast, single rays: " + std::to_string(rays.size() / singleTime / 1e6) + " Mrays/s (" + std::to_string(hitCount) + " of " + std::to_string(rays.size()) + " rays hit).");
+
+    for (uint32_t threadCount : {1, 2, 4, 8, 16}) {
+        startTime = window->getTime();
+        octree->raycast(rays, hits, threadCount);
+        double batchTime = window->getTime() - startTime;
+        spdlog::info("Octree raycast, batched on " + std::to_string(threadCount) + " threads: " + std::to_string(rays.size() / batchTime / 1e6) + " Mrays/s.");
+    }
+
+    // Coherent primary rays, one per pixel of a pinhole view looking at the volume.
+    // Packets are timed on a single thread so the numbers are per core
+    glm::vec3 eye = bounds.center + glm::vec3(0.6f, 0.5f, -0.7f) * radius;
+    glm::vec3 front = glm::normalize(bounds.center - eye);
+    glm::vec3 right = glm::normalize(glm::cross(front, glm::vec3(0.0f, 1.0f, 0.0f)));
+    glm::vec3 up = glm::cross(right, front);
+
+    std::vector<Ray> primaryRays;
+    primaryRays.reserve(RAYCAST_BENCHMARK_IMAGE_SIZE * RAYCAST_BENCHMARK_IMAGE_SIZE);
+    for (uint32_t y = 0; y < RAYCAST_BENCHMARK_IMAGE_SIZE; y++) {
+        for (uint32_t x = 0; x < RAYCAST_BENCHMARK_IMAGE_SIZE; x++) {
+            float u = ((x + 0.5f) / RAYCAST_BENCHMARK_IMAGE_SIZE) * 2.0f - 1.0f;
+            float v = ((y + 0.5f) / RAYCAST_BENCHMARK_IMAGE_SIZE) * 2.0f - 1.0f;
+            primaryRays.push_back({
+                .origin = eye,
+                .direction = glm::normalize(front + (right * u + up * v) * 0.5f),
+                .tMax = 2.0f * radius
+            });
+        }
+    }
+
+    std::vector<Hit> primaryHits(primaryRays.size());
+    double scalarRate = 0.0;
+    for (uint32_t packetWidth : {1, 4, 8}) {
+        if (packetWidth > RAY_PACKET_MAX_WIDTH) {
+            spdlog::info("Octree raycast, " + std::to_string(packetWidth) + " wide packets: not available in this build.");
+            continue;
+        }
+
+        startTime = window->getTime();
+        octree->raycastPackets(primaryRays, primaryHits, packetWidth);
+        double rate = primaryRays.size() / (window->getTime() - startTime) / 1e6;
+        if (packetWidth == 1) scalarRate = rate;
+
+        std::string pathName = packetWidth == 1 ? "scalar" : std::to_string(packetWidth) + " wide packets";
+        spdlog::info("Octree raycast, primary rays, " + pathName + ": " + std::to_string(rate) + " Mrays/s per core (" + std::to_string(rate / scalarRate) + "x scalar).");
+    }
+
+    delete octree;
+}
+
+void RenderEngine::benchmarkVoxelizer(std::string objPath) {
+    Mesh* mesh = Utils::loadOBJFile(objPath, "assets/materials");
+    int previousMode = Voxelizer::mode;
+
+    // Normalizing an already normalized mesh is a no-op, so both modes see the same triangles
+    Voxelizer::mode = VOXELIZATION_CONSERVATIVE;
+    double startTime = window->getTime();
+    Volume conservativeVolume = Voxelizer::voxelizeMesh(mesh, texturePool->getImageCache());
+    double conservativeTime = (window->getTime() - startTime) * 1000.0;
+
+    Voxelizer::mode = VOXELIZATION_SAMPLING;
+    startTime = window->getTime();
+    Volume sampledVolume = Voxelizer::voxelizeMesh(mesh, texturePool->getImageCache());
+    double samplingTime = (window->getTime() - startTime) * 1000.0;
+
+    Voxelizer::mode = previousMode;
+    delete mesh;
+
+    // Holes are surface cells, as found by the overlap test, that no sampled point landed in
+    std::unordered_set<glm::ivec3> sampledCells;
+    for (const Voxel& voxel : sampledVolume.voxels)
+        sampledCells.insert(glm::ivec3(glm::floor(voxel.position)));
+
+    size_t holeCount = 0;
+    for (const Voxel& voxel : conservativeVolume.voxels)
+        if (sampledCells.find(glm::ivec3(glm::floor(voxel.position))) == sampledCells.end())
+            holeCount++;
+    double holeRate = conservativeVolume.voxels.size() > 0 ? 100.0 * holeCount / conservativeVolume.voxels.size() : 0.0;
+
+    spdlog::info("Conservative voxelization: " + std::to_string(conservativeVolume.voxels.size()) + " voxels in " + std::to_string(conservativeTime) + " ms.");
+    spdlog::info("Sampling voxelization: " + std::to_string(sampledVolume.voxels.size()) + " points in " + std::to_string(sampledCells.size()) + " cells in " + std::to_string(samplingTime) + " ms. " + std::to_string(holeCount) + " surface cells missed (" + std::to_string(holeRate) + "% hole rate).");
+
+    // Thread scaling of the current mode. Every run must give the voxels of the single threaded one
+    mesh = Utils::loadOBJFile(objPath, "assets/materials");
+    int previousThreadCount = Voxelizer::threadCount;
+    double baseTime = 0.0;
+    std::vector<Voxel> baseVoxels;
+    for (int threadCount : {1, 2, 4, 8, 16}) {
+        Voxelizer::threadCount = threadCount;
+        startTime = window->getTime();
+        Volume volume = Voxelizer::voxelizeMesh(mesh, texturePool->getImageCache());
+        double voxelizationTime = (window->getTime() - startTime) * 1000.0;
+
+        bool identical = true;
+        if (threadCount == 1) {
+            baseTime = voxelizationTime;
+            baseVoxels = volume.voxels;
+        }
+        else {
+            identical = volume.voxels.size() == baseVoxels.size();
+            for (size_t i = 0; identical && i < baseVoxels.size(); i++)
+                identical = volume.voxels[i].position == baseVoxels[i].position && volume.voxels[i].normal == baseVoxels[i].normal;
+        }
+        spdlog::info("Voxelization, " + std::to_string(threadCount) + " threads: " + std::to_string(voxelizationTime) + " ms (" + std::to_string(baseTime / voxelizationTime) + "x speedup)" + (identical ? "." : ", output differs from 1 thread!"));
+    }
+
+    Voxelizer::threadCount = previousThreadCount;
+    delete mesh;
+}
+
+void RenderEngine::benchmarkVoxelScales(std::string objPath) {
+    // The occupancy grid switches from dense to paged as the scale grows, its size is logged by every voxelization
+    Mesh* mesh = Utils::loadOBJFile(objPath, "assets/materials");
+    int previousScale = Voxelizer::scale;
+    for (int scale : {60, 128, 256, 512, 1024, 2048}) {
+        Voxelizer::scale = scale;
+        double startTime = window->getTime();
+        Volume volume = Voxelizer::voxelizeMesh(mesh, texturePool->getImageCache());
+        double voxelizationTime = (window->getTime() - startTime) * 1000.0;
+
+        size_t voxelBytes = volume.voxels.size() * sizeof(Voxel);
+        spdlog::info("Voxelization at scale " + std::to_string(scale) + ": " + std::to_string(volume.voxels.size()) + " voxels (" + std::to_string(voxelBytes / (1024 * 1024)) + " MB) in " + std::to_string(voxelizationTime) + " ms.");
+    }
+
+    Voxelizer::scale = previousScale;
+    delete mesh;
+}
+
+void RenderEngine::benchmarkVolumeMeshing(std::string objPath) {
+    Mesh* mesh = Utils::loadOBJFile(objPath, "assets/materials");
+    Volume volume = Voxelizer::voxelizeMesh(mesh, texturePool->getImageCache());
+    delete mesh;
+
+    // Every mode against the 12 triangles per voxel of the cube mesh
+    int previousMeshing = Voxelizer::meshing;
+    size_t cubeTriangleCount = 0;
+    double cubeTime = 0.0;
+    for (int meshing : {VOLUME_MESHING_CUBES, VOLUME_MESHING_CULLED, VOLUME_MESHING_GREEDY}) {
+        Voxelizer::meshing = meshing;
+        double startTime = window->getTime();
+        Mesh* volumeMesh = Voxelizer::triangulateVolume(volume);
+        double meshingTime = (window->getTime() - startTime) * 1000.0;
+        size_t triangleCount = volumeMesh->getNumIndices() / 3;
+        size_t meshBytes = volumeMesh->getNumVertices() * sizeof(Vertex) + volumeMesh->getNumIndices() * sizeof(uint32_t);
+        delete volumeMesh;
+
+        if (meshing == VOLUME_MESHING_CUBES) {
+            cubeTriangleCount = triangleCount;
+            cubeTime = meshingTime;
+        }
+        std::string meshingName = meshing == VOLUME_MESHING_CUBES ? "Cube" : (meshing == VOLUME_MESHING_CULLED ? "Culled face" : "Greedy");
+        spdlog::info(meshingName + " meshing: " + std::to_string(triangleCount) + " triangles (" + std::to_string((double)cubeTriangleCount / std::max(triangleCount, (size_t)1)) + "x fewer), " + std::to_string(meshBytes / (1024 * 1024)) + " MB in " + std::to_string(meshingTime) + " ms (" + std::to_string(cubeTime / meshingTime) + "x faster).");
+    }
+
+    // Chunks are meshed in parallel, every thread count must give the same mesh
+    Voxelizer::meshing = VOLUME_MESHING_GREEDY;
+    int previousThreadCount = Voxelizer::threadCount;
+    double baseTime = 0.0;
+    std::vector<Vertex> baseVertices;
+    for (int threadCount : {1, 2, 4, 8, 16}) {
+        Voxelizer::threadCount = threadCount;
+        double startTime = window->getTime();
+        Mesh* volumeMesh = Voxelizer::triangulateVolume(volume);
+        double meshingTime = (window->getTime() - startTime) * 1000.0;
+
+        bool identical = true;
+        if (threadCount == 1) {
+            baseTime = meshingTime;
+            baseVertices = volumeMesh->getVertices();
+        }
+        else {
+            std::vector<Vertex> vertices = volumeMesh->getVertices();
+            identical = vertices.size() == baseVertices.size();
+            for (size_t i = 0; identical && i < baseVertices.size(); i++)
+                identical = vertices[i].position == baseVertices[i].position && vertices[i].normal == baseVertices[i].normal;
+        }
+        delete volumeMesh;
+        spdlog::info("Greedy meshing, " + std::to_string(threadCount) + " threads: " + std::to_string(meshingTime) + " ms (" + std::to_string(baseTime / meshingTime) + "x speedup)" + (identical ? "." : ", output differs from 1 thread!"));
+    }
+
+    Voxelizer::threadCount = previousThreadCount;
+    Voxelizer::meshing = previousMeshing;
+}
+
+void RenderEngine::benchmarkIsoSurface(std::string objPath) {
+    // Throughput is logged by every extraction, every thread count must give the same mesh
+    Mesh* mesh = Utils::loadOBJFile(objPath, "assets/materials");
+    Volume volume = Voxelizer::voxelizeMesh(mesh, texturePool->getImageCache());
+    delete mesh;
+
+    double baseTime = 0.0;
+    std::vector<Vertex> baseVertices;
+    std::vector<uint32_t> baseIndices;
+    for (int threadCount : {1, 2, 4, 8, 16}) {
+        double startTime = window->getTime();
+        Mesh* surfaceMesh = IsoSurface::extract(volume, threadCount);
+        double extractionTime = (window->getTime() - startTime) * 1000.0;
+
+        bool identical = true;
+        if (threadCount == 1) {
+            baseTime = extractionTime;
+            baseVertices = surfaceMesh->getVertices();
+            baseIndices = surfaceMesh->getIndices();
+        }
+        else {
+            std::vector<Vertex> vertices = surfaceMesh->getVertices();
+            identical = vertices.size() == baseVertices.size() && surfaceMesh->getIndices() == baseIndices;
+            for (size_t i = 0; identical && i < baseVertices.size(); i++)
+                identical = vertices[i].position == baseVertices[i].position && vertices[i].normal == baseVertices[i].normal;
+        }
+        delete surfaceMesh;
+        spdlog::info("Isosurface extraction, " + std::to_string(threadCount) + " threads: " + std::to_string(extractionTime) + " ms (" + std::to_string(baseTime / extractionTime) + "x speedup)" + (identical ? "." : ", output differs from 1 thread!"));
+    }
+}
+
+void RenderEngine::benchmarkSVORoundTrip() {
+    if (targetLinearOctree == nullptr) return;
+
+    // Written to the temporary folder, so the file does not show up under Load SVO
+    std::string svoPath = (std::filesystem::temp_directory_path() / (targetVolumeName + "_roundtrip.svo")).string();
+    double saveStartTime = window->getTime();
+    bool saved = targetLinearOctree->saveToFile(svoPath);
+    double saveTime = (window->getTime() - saveStartTime) * 1000.0;
+    if (!saved) return;
+
+    LinearOctree loadedOctree;
+    double loadStartTime = window->getTime();
+    bool loaded = loadedOctree.loadFromFile(svoPath);
+    double loadTime = (window->getTime() - loadStartTime) * 1000.0;
+
+    bool identical = loaded && targetLinearOctree->isEqual(loadedOctree);
+    spdlog::info("SVO round trip of " + std::to_string(targetLinearOctree->getNodeCount()) + " nodes: saved in " + std::to_string(saveTime) + " ms, mapped in " + std::to_string(loadTime) + " ms" + (identical ? ", identical." : ", loaded octree differs!"));
+
+    std::filesystem::remove(svoPath);
+}
+
+void RenderEngine::benchmarkVoxelPipelines() {
+    // Frames are timed as they are rendered, see updateVoxelPipelineBenchmark
+    voxelPipelineBenchmarkFrame = 0;
+    voxelPipelineBenchmarkTimes[0] = 0.0;
+    voxelPipelineBenchmarkTimes[1] = 0.0;
+    voxelPipelineBenchmarkInstancing = uiStates.useVoxelCubeInstancing;
+}
+
+void RenderEngine::updateVoxelPipelineBenchmark() {
+    // The geometry shader pipeline renders first, then the instanced one
+    int pipelineFrames = VOXEL_PIPELINE_BENCHMARK_WARMUP_FRAMES + VOXEL_PIPELINE_BENCHMARK_FRAMES;
+    int pipeline = voxelPipelineBenchmarkFrame / pipelineFrames;
+    int frame = voxelPipelineBenchmarkFrame % pipelineFrames;
+
+    // The delta time of this frame is the previous one, past the warmup it used the same pipeline
+    if (pipeline < 2 && frame >= VOXEL_PIPELINE_BENCHMARK_WARMUP_FRAMES)
+        voxelPipelineBenchmarkTimes[pipeline] += deltaTime;
+
+    if (pipeline == 2) {
+        size_t voxelCount = 0;
+        for (Mesh* mesh : voxelScene)
+            voxelCount += mesh->getNumVertices();
+
+        double geometryTime = voxelPipelineBenchmarkTimes[0] * 1000.0 / VOXEL_PIPELINE_BENCHMARK_FRAMES;
+        double instancedTime = voxelPipelineBenchmarkTimes[1] * 1000.0 / VOXEL_PIPELINE_BENCHMARK_FRAMES;
+        spdlog::info("Voxel pipelines, " + std::to_string(voxelCount) + " voxels over " + std::to_string(VOXEL_PIPELINE_BENCHMARK_FRAMES) + " frames:");
+        spdlog::info("Geometry shader cubes: " + std::to_string(geometryTime) + " ms/frame | " + std::to_string(1000.0 / geometryTime) + " FPS.");
+        spdlog::info("Instanced cubes: " + std::to_string(instancedTime) + " ms/frame | " + std::to_string(1000.0 / instancedTime) + " FPS (" + std::to_string(geometryTime / instancedTime) + "x faster).");
+
+        uiStates.useVoxelCubeInstancing = voxelPipelineBenchmarkInstancing;
+        voxelPipelineBenchmarkFrame = -1;
+        return;
+    }
+
+    uiStates.useVoxelCubeInstancing = pipeline == 1;
+    voxelPipelineBenchmarkFrame++;
+}
+
 void RenderEngine::addMeshToScene(Mesh* mesh) {
+    // Scene meshes are drawn indexed, empty ones (an isosurface of nothing) are dropped here
     mesh->uploadMesh(vulkan.device);
+    if (mesh->getVertexBuffer() == nullptr || mesh->getIndexBuffer() == nullptr) {
+        spdlog::warn("Empty mesh not added to the scene.");
+        deleteMesh(mesh);
+        return;
+    }
     scene.push_back(mesh);
 }
 
 void RenderEngine::addVolumeMeshToScene(Mesh* mesh) {
+    size_t meshBytes = mesh->getNumVertices() * sizeof(VoxelVertex) + mesh->getNumIndices() * sizeof(uint32_t);
+    size_t fullMeshBytes = mesh->getNumVertices() * (sizeof(Vertex) + sizeof(uint32_t));
+    spdlog::info("Volume mesh of " + std::to_string(mesh->getNumVertices()) + " voxels: " + std::to_string(meshBytes / 1024) + " KB (" + std::to_string(fullMeshBytes / 1024) + " KB as indexed full vertices).");
     mesh->uploadMesh(vulkan.device);
     voxelScene.push_back(mesh);
 }
 
 void RenderEngine::addDebugMeshToScene(Mesh* mesh) {
     mesh->uploadMesh(vulkan.device);
+    if (mesh->getVertexBuffer() == nullptr || mesh->getIndexBuffer() == nullptr) {
+        spdlog::warn("Empty mesh not added to the debug scene.");
+        deleteMesh(mesh);
+        return;
+    }
     debugScene.push_back(mesh);
 }
 
 void RenderEngine::clearScene() {
     // Clear scene and free resources
-    for (Mesh* mesh : scene) {
-        vulkan.device->freeDeviceMemory(mesh->getVertexBuffer()->getDeviceMemory());
-        vulkan.device->freeDeviceMemory(mesh->getIndexBuffer()->getDeviceMemory());
-            delete mesh;
-    }
+    for (Mesh* mesh : scene)
+        deleteMesh(mesh);
     scene.clear();
 
-    for (Mesh* mesh : voxelScene) {
-        vulkan.device->freeDeviceMemory(mesh->getVertexBuffer()->getDeviceMemory());
-        vulkan.device->freeDeviceMemory(mesh->getIndexBuffer()->getDeviceMemory());
-        delete mesh;
-    }
+    for (Mesh* mesh : voxelScene)
+        deleteMesh(mesh);
     voxelScene.clear();
 
-    for (Mesh* mesh : debugScene) {
-        vulkan.device->freeDeviceMemory(mesh->getVertexBuffer()->getDeviceMemory());
-        vulkan.device->freeDeviceMemory(mesh->getIndexBuffer()->getDeviceMemory());
-        delete mesh;
-    }
+    for (Mesh* mesh : debugScene)
+        deleteMesh(mesh);
     debugScene.clear();
 }
 
@@ -960,6 +1634,15 @@ void RenderEngine::deletePipeline(Pipeline* pipeline) {
     delete pipeline;
 }
 
+void RenderEngine::deleteMesh(Mesh* mesh) {
+    // Meshes that were never uploaded, or drawn without indices, miss some buffers
+    if (mesh->getVertexBuffer() != nullptr)
+        vulkan.device->freeDeviceMemory(mesh->getVertexBuffer()->getDeviceMemory());
+    if (mesh->getIndexBuffer() != nullptr)
+        vulkan.device->freeDeviceMemory(mesh->getIndexBuffer()->getDeviceMemory());
+    delete mesh;
+}
+
 void RenderEngine::deleteTexture(Texture* texture) {
     // Destroy the texture components
     vulkan.device->destroySampler(texture->getSampler());
@@ -1,7 +1,16 @@
 #ifndef _RENDER_ENGINE_H_
 #define _RENDER_ENGINE_H_
 
+#define RAYCAST_BENCHMARK_RAY_COUNT 100000
+#define RAYCAST_BENCHMARK_IMAGE_SIZE 512
+// Frames each voxel pipeline renders for the benchmark, the first ones are not timed
+#define VOXEL_PIPELINE_BENCHMARK_WARMUP_FRAMES 30
+#define VOXEL_PIPELINE_BENCHMARK_FRAMES 300
+// Indices of the cube shared by every voxel instance
+#define VOXEL_CUBE_INDEX_COUNT 36
+
 #include <cmath>
+#include <random>
 #include <imgui/imgui.h>
 #include <imgui/backends/imgui_impl_glfw.h>
 #include <imgui/backends/imgui_impl_vulkan.h>
@@ -22,6 +31,10 @@
 #include "Window.hpp"
 #include "Voxelizer.hpp"
 #include "Octree.hpp"
+#include "LinearOctree.hpp"
+#include "VoxelDAG.hpp"
+#include "VolumeCache.hpp"
+#include "IsoSurface.hpp"
 
 // Struct that holds all vulkan context variables
 struct Vulkan {
@@ -51,10 +64,13 @@ struct Render {
     RenderPass* renderPass;
     std::vector<ShaderModule*> defaultShaders;
     std::vector<ShaderModule*> voxelShaders;
+    std::vector<ShaderModule*> voxelCubeShaders;
     std::vector<ShaderModule*> debugShaders;
     Pipeline* defaultPipeline;
     Pipeline* voxelPipeline;
+    Pipeline* voxelCubePipeline;
     Pipeline* debugPipeline;
+    Buffer* voxelCubeIndexBuffer;
     Material defaultMaterial;
 };
 
@@ -69,6 +85,7 @@ struct PushConstants {
 struct GeometryConstants {
     glm::mat4 mvp;
     glm::vec4 octreeData;
+    glm::vec4 octreeMin;
 };
 
 struct FragmentConstants { 
@@ -81,6 +98,12 @@ struct UIStates {
     bool showCameraProperties;
     bool showDebugStructures;
     int octreeTargetDepth;
+    bool useMortonOctreeBuilder;
+    int octreeBuildThreads;
+    bool useVoxelDAG;
+    bool streamVoxelization;
+    bool cacheVoxelization;
+    bool useVoxelCubeInstancing;
 };
 
 class RenderEngine {
@@ -100,12 +123,21 @@ private:
     Vulkan vulkan;
     Render render;
     TexturePool* texturePool;
+    VolumeCache* volumeCache;
     std::vector<Mesh*> scene;
     std::vector<Mesh*> voxelScene;
     std::vector<Mesh*> debugScene;
     Octree* targetOctree;
+    LinearOctree* targetLinearOctree;
+    VoxelDAG* targetVoxelDAG;
+    std::shared_ptr<VoxelPyramid> targetPyramid;
+    std::string targetVolumeName;
     UIStates uiStates;
     double deltaTime, lastTime;
+    // Frame of the voxel pipeline benchmark, -1 when it is not running
+    int voxelPipelineBenchmarkFrame;
+    double voxelPipelineBenchmarkTimes[2];
+    bool voxelPipelineBenchmarkInstancing;
 
     void initWindow();
     void initImgui();
@@ -124,8 +156,24 @@ private:
     void renderUI();
     void addOBJToScene(std::string objPath);
     void addVoxelizedOBJToScene(std::string objPath);
+    void addTriangulatedOBJToScene(std::string objPath);
+    void addIsoSurfaceToScene(std::string objPath);
+    void benchmarkOctreeBuild(std::string objPath);
+    void benchmarkOctreeRaycast(std::string objPath);
+    void benchmarkVoxelizer(std::string objPath);
+    void benchmarkVoxelScales(std::string objPath);
+    void benchmarkVolumeMeshing(std::string objPath);
+    void benchmarkIsoSurface(std::string objPath);
+    void benchmarkSVORoundTrip();
+    void benchmarkVoxelPipelines();
+    void updateVoxelPipelineBenchmark();
+    void addSVOToScene(std::string svoPath);
+    void saveTargetOctree();
+    void refreshVolumeMesh();
+    void clearTargetOctree();
     void clearScene();
     void deletePipeline(Pipeline* pipeline);
+    void deleteMesh(Mesh* mesh);
     void deleteTexture(Texture* texture);
 };
 
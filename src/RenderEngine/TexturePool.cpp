@@ -1,24 +1,29 @@
 #include "TexturePool.hpp"
 
 TexturePool::TexturePool() {
+    imageCache = new ImageCache();
+
     #ifndef NDEBUG
         spdlog::info("Texture pool successfully created.");
     #endif
 }
 
-TexturePool::~TexturePool() {}
+TexturePool::~TexturePool() {
+    delete imageCache;
+}
 
 Texture* TexturePool::requireTexture(Device* device, CommandPool* commandPool, std::string textureName) {
     // Check if texture already in pool, if not load it and return.
     // Else, just return
     if (pool.find(textureName) == pool.end()) {
-        ImageData newImageData = Utils::loadImageFile(textureName);
+        // Decoded through the image cache, the voxelizer reads the same images
+        const ImageData* newImageData = imageCache->requireImage(textureName);
 
         // If incoming loaded image failed to load, return the default texture
-        if (!newImageData.loaded)
+        if (newImageData == nullptr)
             return pool["assets/textures/default.png"];
 
-        Texture* newTexture = new Texture(device, commandPool, newImageData); 
+        Texture* newTexture = new Texture(device, commandPool, *newImageData); 
         pool.insert(std::pair<std::string, Texture*>(textureName, newTexture));
     }
     return pool[textureName];
@@ -27,3 +32,7 @@ Texture* TexturePool::requireTexture(Device* device, CommandPool* commandPool, s
 std::map<std::string, Texture*> TexturePool::getPool() {
     return pool;
 }
+
+ImageCache* TexturePool::getImageCache() {
+    return imageCache;
+}
@@ -5,6 +5,7 @@
 #include "../Vulkan/Device.hpp"
 #include "../Vulkan/CommandPool.hpp"
 #include "Texture.hpp"
+#include "ImageCache.hpp"
 #include "Utils.hpp"
 
 class TexturePool {
@@ -14,8 +15,10 @@ public:
 
     Texture* requireTexture(Device* device, CommandPool* commandPool, std::string textureName);
     std::map<std::string, Texture*> getPool();
+    ImageCache* getImageCache();
 private:
     std::map<std::string, Texture*> pool;
+    ImageCache* imageCache;
 };
 
 #endif
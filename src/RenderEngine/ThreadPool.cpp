@@ -0,0 +1,123 @@
+#include "ThreadPool.hpp"
+
+static thread_local ThreadPool* currentPool = nullptr;
+static thread_local uint32_t currentWorkerIndex = 0;
+
+ThreadPool::ThreadPool(uint32_t threadCount) {
+    if (threadCount == 0) threadCount = 1;
+
+    queuedTasks = 0;
+    pendingTasks = 0;
+    stopping = false;
+
+    for (uint32_t i = 0; i < threadCount; i++)
+        queues.push_back(std::make_unique<WorkQueue>());
+
+    for (uint32_t i = 1; i < threadCount; i++)
+        workers.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    sleepCondition.notify_all();
+
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    // Workers push into their own queue, any other thread feeds worker 0
+    uint32_t queueIndex = currentPool == this ? currentWorkerIndex : 0;
+
+    pendingTasks++;
+    {
+        std::lock_guard<std::mutex> lock(queues[queueIndex]->mutex);
+        queuedTasks++;
+        queues[queueIndex]->tasks.push_back(std::move(task));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    sleepCondition.notify_one();
+}
+
+void ThreadPool::wait() {
+    // The calling thread helps until every submitted task, including nested ones, is done
+    ThreadPool* previousPool = currentPool;
+    currentPool = this;
+    currentWorkerIndex = 0;
+
+    while (pendingTasks > 0) {
+        if (runNextTask(0)) continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepCondition.wait(lock, [&] { return pendingTasks == 0 || queuedTasks > 0; });
+    }
+
+    currentPool = previousPool;
+}
+
+uint32_t ThreadPool::getThreadCount() {
+    return queues.size();
+}
+
+uint32_t ThreadPool::getWorkerIndex() {
+    // Index of the calling thread inside this pool, threads outside of it count as worker 0
+    return currentPool == this ? currentWorkerIndex : 0;
+}
+
+uint32_t ThreadPool::getHardwareThreadCount() {
+    uint32_t threadCount = std::thread::hardware_concurrency();
+    return threadCount == 0 ? 1 : threadCount;
+}
+
+void ThreadPool::workerLoop(uint32_t workerIndex) {
+    currentPool = this;
+    currentWorkerIndex = workerIndex;
+
+    while (true) {
+        if (runNextTask(workerIndex)) continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepCondition.wait(lock, [&] { return stopping || queuedTasks > 0; });
+        if (stopping && queuedTasks == 0) return;
+    }
+}
+
+bool ThreadPool::runNextTask(uint32_t workerIndex) {
+    std::function<void()> task;
+
+    // Pop the newest task from the own queue, otherwise steal the oldest one from the others
+    uint32_t queueCount = queues.size();
+    for (uint32_t i = 0; i < queueCount && !task; i++) {
+        WorkQueue* queue = queues[(workerIndex + i) % queueCount].get();
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        if (queue->tasks.empty()) continue;
+
+        if (i == 0) {
+            task = std::move(queue->tasks.back());
+            queue->tasks.pop_back();
+        }
+        else {
+            task = std::move(queue->tasks.front());
+            queue->tasks.pop_front();
+        }
+    }
+
+    if (!task) return false;
+
+    queuedTasks--;
+    task();
+
+    if (--pendingTasks == 0) {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        sleepCondition.notify_all();
+    }
+    return true;
+}
@@ -0,0 +1,45 @@
+#ifndef _THREADPOOL_H_
+#define _THREADPOOL_H_
+
+#include <stdint.h>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+// Work stealing pool. The thread calling wait() takes part as worker 0, so a
+// pool of N threads spawns N - 1 background workers. Tasks may submit more
+// tasks, but must not call wait() themselves.
+class ThreadPool {
+public:
+    ThreadPool(uint32_t threadCount);
+    ~ThreadPool();
+
+    void submit(std::function<void()> task);
+    void wait();
+    uint32_t getThreadCount();
+    uint32_t getWorkerIndex();
+    static uint32_t getHardwareThreadCount();
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::mutex sleepMutex;
+    std::condition_variable sleepCondition;
+    std::atomic<uint32_t> queuedTasks;
+    std::atomic<uint32_t> pendingTasks;
+    bool stopping;
+
+    void workerLoop(uint32_t workerIndex);
+    bool runNextTask(uint32_t workerIndex);
+};
+
+#endif
@@ -124,18 +124,138 @@ ImageData Utils::loadImageFile(std::string imagePath) {
         return imageData;
     }
 
-    // Calculate the image data size and store the data into the struct
-    uint32_t _dataSize = (imageData.width * imageData.height * (imageData.channels + 1));
+    // stb_image expands every image to RGBA, whatever the file has
+    imageData.channels = 4;
+    size_t _dataSize = (size_t)imageData.width * imageData.height * imageData.channels;
     imageData.data = std::vector<uint8_t>(_data, _data + _dataSize);
+    stbi_image_free(_data);
 
     spdlog::info("Image " + imagePath + " successfully loaded.");
 
     return imageData;
 }
 
+bool Utils::saveImageFile(std::string imagePath, const ImageData& image) {
+    // 8 bit RGB or RGBA images, the format is picked from the extension
+    if (image.channels != 3 && image.channels != 4) {
+        spdlog::warn("Image " + imagePath + " not written. Only RGB and RGBA images can be saved.");
+        return false;
+    }
+
+    std::string extension = std::filesystem::path(imagePath).extension().string();
+    bool saved = false;
+    if (extension == ".ppm")
+        saved = savePPMFile(imagePath, image);
+    else if (extension == ".png")
+        saved = savePNGFile(imagePath, image);
+    else {
+        spdlog::warn("Unsupported image format: " + imagePath);
+        return false;
+    }
+
+    if (saved)
+        spdlog::info("Image " + imagePath + " successfully written.");
+    else
+        spdlog::warn("Failed to write image file: " + imagePath);
+    return saved;
+}
+
+bool Utils::savePPMFile(std::string imagePath, const ImageData& image) {
+    std::ofstream file(imagePath, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+
+    // Binary PPM has no alpha channel
+    file << "P6\n" << image.width << " " << image.height << "\n255\n";
+    for (size_t pixel = 0; pixel < (size_t)image.width * image.height; pixel++)
+        file.write((const char*)&image.data[pixel * image.channels], 3);
+    return (bool)file;
+}
+
+bool Utils::savePNGFile(std::string imagePath, const ImageData& image) {
+    std::ofstream file(imagePath, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+
+    uint32_t crcTable[256];
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (uint32_t bit = 0; bit < 8; bit++)
+            crc = (crc & 1) ? 0xEDB88320 ^ (crc >> 1) : crc >> 1;
+        crcTable[i] = crc;
+    }
+
+    auto appendBigEndian = [](std::vector<uint8_t>& bytes, uint32_t value) {
+        for (int shift = 24; shift >= 0; shift -= 8)
+            bytes.push_back((value >> shift) & 0xFF);
+    };
+
+    auto writeChunk = [&](const char* type, const std::vector<uint8_t>& data) {
+        std::vector<uint8_t> chunk;
+        appendBigEndian(chunk, data.size());
+        chunk.insert(chunk.end(), type, type + 4);
+        chunk.insert(chunk.end(), data.begin(), data.end());
+
+        // The CRC covers the type and the data, not the length
+        uint32_t crc = 0xFFFFFFFF;
+        for (size_t i = 4; i < chunk.size(); i++)
+            crc = crcTable[(crc ^ chunk[i]) & 0xFF] ^ (crc >> 8);
+        appendBigEndian(chunk, crc ^ 0xFFFFFFFF);
+        file.write((const char*)chunk.data(), chunk.size());
+    };
+
+    const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    file.write((const char*)signature, 8);
+
+    std::vector<uint8_t> header;
+    appendBigEndian(header, image.width);
+    appendBigEndian(header, image.height);
+    header.push_back(8);                                // Bit depth
+    header.push_back(image.channels == 4 ? 6 : 2);      // RGBA or RGB
+    header.push_back(0);                                // Deflate
+    header.push_back(0);                                // Adaptive filtering
+    header.push_back(0);                                // No interlace
+    writeChunk("IHDR", header);
+
+    // Every scanline starts with its filter type, none is used
+    size_t rowSize = (size_t)image.width * image.channels;
+    std::vector<uint8_t> scanlines;
+    scanlines.reserve((rowSize + 1) * image.height);
+    for (int y = 0; y < image.height; y++) {
+        scanlines.push_back(0);
+        scanlines.insert(scanlines.end(), image.data.begin() + y * rowSize, image.data.begin() + (y + 1) * rowSize);
+    }
+
+    // Zlib stream made of stored deflate blocks, so no compressor is needed
+    std::vector<uint8_t> compressed = {0x78, 0x01};
+    size_t offset = 0;
+    do {
+        uint16_t blockSize = (uint16_t)std::min<size_t>(scanlines.size() - offset, 0xFFFF);
+        compressed.push_back(offset + blockSize == scanlines.size() ? 1 : 0);
+        compressed.push_back(blockSize & 0xFF);
+        compressed.push_back(blockSize >> 8);
+        compressed.push_back(~blockSize & 0xFF);
+        compressed.push_back((~blockSize >> 8) & 0xFF);
+        compressed.insert(compressed.end(), scanlines.begin() + offset, scanlines.begin() + offset + blockSize);
+        offset += blockSize;
+    } while (offset < scanlines.size());
+
+    uint32_t adlerA = 1, adlerB = 0;
+    for (uint8_t byte : scanlines) {
+        adlerA = (adlerA + byte) % 65521;
+        adlerB = (adlerB + adlerA) % 65521;
+    }
+    appendBigEndian(compressed, (adlerB << 16) | adlerA);
+    writeChunk("IDAT", compressed);
+    writeChunk("IEND", {});
+
+    return (bool)file;
+}
+
 std::vector<std::string> Utils::listFolderFiles(std::string folderPath) {
     // List files in folder and return a vector with them
     std::vector<std::string> files;
+    if (!std::filesystem::is_directory(folderPath))
+        return files;
+
     for (const auto& file : std::filesystem::directory_iterator(folderPath))
         files.push_back(file.path());
     return files;
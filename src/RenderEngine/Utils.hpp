@@ -26,10 +26,14 @@ public:
     static std::vector<uint32_t> loadShaderCode(std::string shaderPath);
     static Mesh* loadOBJFile(std::string OBJPath, std::string materialsDir = "");
     static ImageData loadImageFile(std::string imagePath);
+    static bool saveImageFile(std::string imagePath, const ImageData& image);
     static std::vector<std::string> listFolderFiles(std::string folderPath);
     static Mesh* getDebugBoxMesh(AABB aabb, glm::vec3 color);
 private:
     Utils();
+
+    static bool savePPMFile(std::string imagePath, const ImageData& image);
+    static bool savePNGFile(std::string imagePath, const ImageData& image);
 };
 
 #endif
@@ -0,0 +1,357 @@
+#include "VolumeCache.hpp"
+
+VolumeCache::VolumeCache(std::string directory, size_t maxBytes) {
+    this->directory = directory;
+    this->maxBytes = maxBytes;
+    this->stats = {
+        .hitCount = 0,
+        .missCount = 0,
+        .storeCount = 0,
+        .evictionCount = 0
+    };
+}
+
+bool VolumeCache::getKey(std::string OBJPath, std::string materialFolder, bool streamed, uint64_t& key) {
+    auto startTime = std::chrono::steady_clock::now();
+    uint64_t contentHash;
+    if (!hashFile(OBJPath, contentHash)) {
+        spdlog::warn("Failed to hash OBJ file for the volume cache: " + OBJPath);
+        return false;
+    }
+
+    // Every parameter the voxels depend on. Density and the seed only change sampled
+    // volumes, and streamed files are voxelized without their materials
+    bool sampled = Voxelizer::mode == VOXELIZATION_SAMPLING;
+    uint64_t parameters[] = {
+        VOLUME_CACHE_VERSION,
+        VOXELIZER_VERSION,
+        (uint64_t)Voxelizer::scale,
+        (uint64_t)Voxelizer::mode,
+        sampled ? (uint64_t)Voxelizer::density : 0,
+        sampled ? (uint64_t)Voxelizer::seed : 0,
+        streamed ? 1ull : 0ull,
+        streamed ? 0 : hashFolder(materialFolder)
+    };
+    key = hashBytes(parameters, sizeof(parameters), contentHash);
+
+    double hashTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    spdlog::info("Volume cache key of " + OBJPath + " computed in " + std::to_string(hashTime) + " ms.");
+    return true;
+}
+
+bool VolumeCache::load(uint64_t key, Volume& volume) {
+    std::string path = getEntryPath(key);
+    int fileDescriptor = open(path.c_str(), O_RDONLY);
+    if (fileDescriptor == -1) {
+        stats.missCount++;
+        logStats("miss", key);
+        return false;
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+    struct stat fileStat;
+    void* data = MAP_FAILED;
+    if (fstat(fileDescriptor, &fileStat) != -1 && (size_t)fileStat.st_size >= sizeof(VolumeCacheHeader))
+        data = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    close(fileDescriptor);
+
+    // Entries that do not match their name are dropped, they are rewritten by the next store
+    const VolumeCacheHeader* header = (const VolumeCacheHeader*)data;
+    size_t mappedSize = data == MAP_FAILED ? 0 : fileStat.st_size;
+    bool valid = data != MAP_FAILED &&
+        header->magic == VOLUME_CACHE_MAGIC && header->version == VOLUME_CACHE_VERSION && header->key == key &&
+        isSectionInside(header->voxelOffset, header->voxelCount, sizeof(CachedVoxel), mappedSize) &&
+        isSectionInside(header->spanOffset, header->spanCount, sizeof(VoxelSpan), mappedSize) &&
+        isSectionInside(header->fieldOffset, header->fieldValueCount, sizeof(float), mappedSize) &&
+        (header->fieldValueCount == 0 || getFieldValueCount(header->fieldSize) == header->fieldValueCount);
+    if (!valid) {
+        if (data != MAP_FAILED) munmap(data, mappedSize);
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        spdlog::warn("Invalid volume cache entry " + path + " deleted.");
+        stats.missCount++;
+        logStats("miss", key);
+        return false;
+    }
+    madvise(data, mappedSize, MADV_SEQUENTIAL);
+
+    const char* bytes = (const char*)data;
+    const CachedVoxel* cachedVoxels = (const CachedVoxel*)(bytes + header->voxelOffset);
+    volume.scale = header->scale;
+    volume.voxels = std::vector<Voxel>(header->voxelCount);
+    for (size_t i = 0; i < header->voxelCount; i++) {
+        volume.voxels[i].position = glm::vec3(cachedVoxels[i].cell) + glm::vec3(0.5f);
+        volume.voxels[i].normal = cachedVoxels[i].normal;
+        volume.voxels[i].renderData = cachedVoxels[i].renderData;
+    }
+
+    const VoxelSpan* spans = (const VoxelSpan*)(bytes + header->spanOffset);
+    volume.solidSpans = std::vector<VoxelSpan>(spans, spans + header->spanCount);
+
+    volume.distanceField = nullptr;
+    if (header->fieldValueCount > 0) {
+        auto field = std::make_shared<DistanceField>(header->fieldMinCell, header->fieldSize);
+        std::memcpy(field->getBrickData(), bytes + header->fieldOffset, header->fieldValueCount * sizeof(float));
+        volume.distanceField = field;
+    }
+    munmap(data, mappedSize);
+
+    // The pyramid is rebuilt from the voxels, which is far cheaper than storing it
+    Voxelizer::buildPyramid(volume);
+
+    // The modification time orders the entries for eviction
+    std::error_code error;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+
+    double loadTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    stats.hitCount++;
+    logStats("hit", key);
+    spdlog::info("Volume cache entry of " + std::to_string(volume.voxels.size()) + " voxels (" + std::to_string(mappedSize / 1024) + " KB) loaded in " + std::to_string(loadTime) + " ms.");
+    return true;
+}
+
+bool VolumeCache::store(uint64_t key, const Volume& volume) {
+    VolumeCacheHeader header = {};
+    header.magic = VOLUME_CACHE_MAGIC;
+    header.version = VOLUME_CACHE_VERSION;
+    header.key = key;
+    header.scale = volume.scale;
+    header.voxelCount = volume.voxels.size();
+    header.voxelOffset = alignOffset(sizeof(VolumeCacheHeader));
+    header.spanCount = volume.solidSpans.size();
+    header.spanOffset = alignOffset(header.voxelOffset + header.voxelCount * sizeof(CachedVoxel));
+    header.fieldOffset = alignOffset(header.spanOffset + header.spanCount * sizeof(VoxelSpan));
+    if (volume.distanceField != nullptr) {
+        header.fieldMinCell = volume.distanceField->getMinCell();
+        header.fieldSize = volume.distanceField->getSize();
+        header.fieldValueCount = volume.distanceField->getBrickCount() * DISTANCE_FIELD_BRICK_CELLS;
+    }
+
+    std::vector<CachedVoxel> cachedVoxels(volume.voxels.size());
+    for (size_t i = 0; i < volume.voxels.size(); i++) {
+        cachedVoxels[i] = {
+            .cell = glm::ivec3(glm::floor(volume.voxels[i].position)),
+            .renderData = volume.voxels[i].renderData,
+            .normal = volume.voxels[i].normal
+        };
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    // Written under a temporary name and renamed, so a failed write never leaves a partial entry
+    std::string path = getEntryPath(key);
+    std::string temporaryPath = path + ".tmp";
+    std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        spdlog::warn("Failed to open volume cache entry for writing: " + temporaryPath);
+        return false;
+    }
+
+    // Zero padding up to the start of each section
+    const char padding[VOLUME_CACHE_SECTION_ALIGNMENT] = {0};
+    file.write((const char*)&header, sizeof(VolumeCacheHeader));
+    file.write(padding, header.voxelOffset - sizeof(VolumeCacheHeader));
+    file.write((const char*)cachedVoxels.data(), header.voxelCount * sizeof(CachedVoxel));
+    file.write(padding, header.spanOffset - (header.voxelOffset + header.voxelCount * sizeof(CachedVoxel)));
+    file.write((const char*)volume.solidSpans.data(), header.spanCount * sizeof(VoxelSpan));
+    file.write(padding, header.fieldOffset - (header.spanOffset + header.spanCount * sizeof(VoxelSpan)));
+    if (volume.distanceField != nullptr)
+        file.write((const char*)volume.distanceField->getBrickData(), header.fieldValueCount * sizeof(float));
+    file.close();
+
+    if (!file) {
+        spdlog::warn("Failed to write volume cache entry: " + temporaryPath);
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        spdlog::warn("Failed to rename volume cache entry: " + temporaryPath);
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+
+    stats.storeCount++;
+    evictEntries(path);
+    logStats("store", key);
+    return true;
+}
+
+VolumeCacheStats VolumeCache::getStats() {
+    return stats;
+}
+
+std::string VolumeCache::getEntryPath(uint64_t key) {
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", (unsigned long long)key);
+    return directory + "/" + name + VOLUME_CACHE_EXTENSION;
+}
+
+void VolumeCache::evictEntries(std::string keptPath) {
+    struct Entry {
+        std::filesystem::path path;
+        std::filesystem::file_time_type lastUse;
+        size_t size;
+    };
+
+    std::error_code error;
+    std::vector<Entry> entries;
+    size_t totalBytes = 0;
+    for (const auto& file : std::filesystem::directory_iterator(directory, error)) {
+        if (!file.is_regular_file(error) || file.path().extension() != VOLUME_CACHE_EXTENSION) continue;
+        Entry entry = {
+            .path = file.path(),
+            .lastUse = file.last_write_time(error),
+            .size = (size_t)file.file_size(error)
+        };
+        totalBytes += entry.size;
+        entries.push_back(entry);
+    }
+
+    // Least recently used first. The entry just stored stays even if it alone is over the limit
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) -> bool {
+        return a.lastUse < b.lastUse;
+    });
+    for (const Entry& entry : entries) {
+        if (totalBytes <= maxBytes) break;
+        if (entry.path == std::filesystem::path(keptPath)) continue;
+        if (!std::filesystem::remove(entry.path, error)) continue;
+
+        totalBytes -= entry.size;
+        stats.evictionCount++;
+        spdlog::info("Volume cache entry " + entry.path.string() + " evicted (" + std::to_string(entry.size / 1024) + " KB).");
+    }
+    spdlog::info("Volume cache holds " + std::to_string(totalBytes / (1024 * 1024)) + " of " + std::to_string(maxBytes / (1024 * 1024)) + " MB.");
+}
+
+void VolumeCache::logStats(std::string event, uint64_t key) {
+    size_t lookupCount = stats.hitCount + stats.missCount;
+    double hitRate = lookupCount > 0 ? 100.0 * stats.hitCount / lookupCount : 0.0;
+    spdlog::info("Volume cache " + event + " for " + getEntryPath(key) + ". " + std::to_string(stats.hitCount) + " hits, " + std::to_string(stats.missCount) + " misses (" + std::to_string(hitRate) + "% hit rate), " + std::to_string(stats.storeCount) + " stores, " + std::to_string(stats.evictionCount) + " evictions.");
+}
+
+bool VolumeCache::hashFile(std::string path, uint64_t& hash) {
+    int fileDescriptor = open(path.c_str(), O_RDONLY);
+    if (fileDescriptor == -1) return false;
+
+    struct stat fileStat;
+    if (fstat(fileDescriptor, &fileStat) == -1) {
+        close(fileDescriptor);
+        return false;
+    }
+    if (fileStat.st_size == 0) {
+        close(fileDescriptor);
+        hash = hashBytes(nullptr, 0, 0);
+        return true;
+    }
+
+    void* data = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    close(fileDescriptor);
+    if (data == MAP_FAILED) return false;
+
+    madvise(data, fileStat.st_size, MADV_SEQUENTIAL);
+    hash = hashBytes(data, fileStat.st_size, 0);
+    munmap(data, fileStat.st_size);
+    return true;
+}
+
+uint64_t VolumeCache::hashFolder(std::string folder) {
+    // Names, sizes and modification times of every file under the folder. Any
+    // edited material or texture changes the key without reading the files
+    std::error_code error;
+    std::vector<std::string> entries;
+    for (const auto& file : std::filesystem::recursive_directory_iterator(folder, error)) {
+        if (!file.is_regular_file(error)) continue;
+        entries.push_back(file.path().string() + ":" + std::to_string(file.file_size(error)) + ":" + std::to_string(file.last_write_time(error).time_since_epoch().count()));
+    }
+
+    // Directory order is unspecified
+    std::sort(entries.begin(), entries.end());
+    uint64_t hash = 0;
+    for (const std::string& entry : entries)
+        hash = hashBytes(entry.data(), entry.size(), hash);
+    return hash;
+}
+
+uint64_t VolumeCache::hashBytes(const void* data, size_t size, uint64_t seed) {
+    // xxHash64. Four independent lanes over 32 byte stripes keep the multipliers busy
+    const uint64_t prime1 = 0x9E3779B185EBCA87ull;
+    const uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+    const uint64_t prime3 = 0x165667B19E3779F9ull;
+    const uint64_t prime4 = 0x85EBCA77C2B2AE63ull;
+    const uint64_t prime5 = 0x27D4EB2F165667C5ull;
+    auto rotate = [](uint64_t value, int bits) -> uint64_t {
+        return (value << bits) | (value >> (64 - bits));
+    };
+    auto round = [&](uint64_t accumulator, uint64_t input) -> uint64_t {
+        return rotate(accumulator + input * prime2, 31) * prime1;
+    };
+    auto read64 = [](const uint8_t* bytes) -> uint64_t {
+        uint64_t value;
+        std::memcpy(&value, bytes, sizeof(uint64_t));
+        return value;
+    };
+    auto read32 = [](const uint8_t* bytes) -> uint64_t {
+        uint32_t value;
+        std::memcpy(&value, bytes, sizeof(uint32_t));
+        return value;
+    };
+
+    const uint8_t* bytes = (const uint8_t*)data;
+    const uint8_t* end = bytes + size;
+    uint64_t hash;
+    if (size >= 32) {
+        uint64_t lanes[4] = {seed + prime1 + prime2, seed + prime2, seed, seed - prime1};
+        for (; end - bytes >= 32; bytes += 32) {
+            lanes[0] = round(lanes[0], read64(bytes));
+            lanes[1] = round(lanes[1], read64(bytes + 8));
+            lanes[2] = round(lanes[2], read64(bytes + 16));
+            lanes[3] = round(lanes[3], read64(bytes + 24));
+        }
+
+        hash = rotate(lanes[0], 1) + rotate(lanes[1], 7) + rotate(lanes[2], 12) + rotate(lanes[3], 18);
+        for (uint64_t lane : lanes)
+            hash = (hash ^ round(0, lane)) * prime1 + prime4;
+    }
+    else hash = seed + prime5;
+    hash += size;
+
+    for (; end - bytes >= 8; bytes += 8)
+        hash = rotate(hash ^ round(0, read64(bytes)), 27) * prime1 + prime4;
+    if (end - bytes >= 4) {
+        hash = rotate(hash ^ (read32(bytes) * prime1), 23) * prime2 + prime3;
+        bytes += 4;
+    }
+    for (; bytes < end; bytes++)
+        hash = rotate(hash ^ (*bytes * prime5), 11) * prime1;
+
+    hash ^= hash >> 33;
+    hash *= prime2;
+    hash ^= hash >> 29;
+    hash *= prime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+bool VolumeCache::isSectionInside(uint64_t offset, uint64_t count, size_t elementSize, size_t fileSize) {
+    // Written so that huge counts or offsets can not overflow
+    return offset % VOLUME_CACHE_SECTION_ALIGNMENT == 0 && offset <= fileSize && count <= (fileSize - offset) / elementSize;
+}
+
+uint64_t VolumeCache::getFieldValueCount(glm::ivec3 fieldSize) {
+    // Same brick grid as DistanceField, checked before it is allocated
+    if (glm::any(glm::lessThan(fieldSize, glm::ivec3(1)))) return 0;
+    // Sizes too large to count match no entry
+    uint64_t valueCount = DISTANCE_FIELD_BRICK_CELLS;
+    for (int axis = 0; axis < 3; axis++) {
+        uint64_t axisBricks = ((uint64_t)fieldSize[axis] + DISTANCE_FIELD_BRICK_SIZE - 1) / DISTANCE_FIELD_BRICK_SIZE;
+        if (valueCount > std::numeric_limits<uint64_t>::max() / axisBricks) return 0;
+        valueCount *= axisBricks;
+    }
+    return valueCount;
+}
+
+uint64_t VolumeCache::alignOffset(uint64_t offset) {
+    return (offset + VOLUME_CACHE_SECTION_ALIGNMENT - 1) & ~(uint64_t)(VOLUME_CACHE_SECTION_ALIGNMENT - 1);
+}
@@ -0,0 +1,97 @@
+#ifndef _VOLUME_CACHE_HPP_
+#define _VOLUME_CACHE_HPP_
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <glm/glm.hpp>
+#include <spdlog/spdlog.h>
+
+#include "Voxelizer.hpp"
+#include "DistanceField.hpp"
+
+/*
+    VOLUME CACHE FILE
+    Little endian, every section aligned to VOLUME_CACHE_SECTION_ALIGNMENT bytes
+
+    | VolumeCacheHeader | CachedVoxel[voxelCount] | VoxelSpan[spanCount] | float bricks[fieldValueCount] |
+
+    The distance field section holds the DistanceField bricks as they are in
+    memory, fieldValueCount is 0 for volumes without one. Entries are named by
+    their key in hex, and their modification time is their last use.
+*/
+#define VOLUME_CACHE_MAGIC 0x314C4F56 // "VOL1"
+#define VOLUME_CACHE_VERSION 1
+#define VOLUME_CACHE_SECTION_ALIGNMENT 64
+#define VOLUME_CACHE_EXTENSION ".vol"
+// Least recently used entries are deleted past this total size
+#define VOLUME_CACHE_DEFAULT_MAX_BYTES (2ull << 30)
+
+// Voxels are cell centers, so the cell and the attributes are enough to restore them
+struct CachedVoxel {
+    glm::ivec3 cell;
+    uint32_t renderData;
+    glm::vec3 normal;
+};
+
+struct VolumeCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    int32_t scale;
+    uint32_t reserved;
+    uint64_t voxelCount;
+    uint64_t voxelOffset;
+    uint64_t spanCount;
+    uint64_t spanOffset;
+    glm::ivec3 fieldMinCell;
+    glm::ivec3 fieldSize;
+    uint64_t fieldValueCount;
+    uint64_t fieldOffset;
+};
+
+struct VolumeCacheStats {
+    size_t hitCount;
+    size_t missCount;
+    size_t storeCount;
+    size_t evictionCount;
+};
+
+// Voxelized volumes on disk, keyed by the content of the OBJ file, its
+// materials and every voxelizer parameter the voxels depend on
+class VolumeCache {
+public:
+    VolumeCache(std::string directory, size_t maxBytes);
+
+    bool getKey(std::string OBJPath, std::string materialFolder, bool streamed, uint64_t& key);
+    bool load(uint64_t key, Volume& volume);
+    bool store(uint64_t key, const Volume& volume);
+    VolumeCacheStats getStats();
+private:
+    std::string directory;
+    size_t maxBytes;
+    VolumeCacheStats stats;
+
+    std::string getEntryPath(uint64_t key);
+    void evictEntries(std::string keptPath);
+    void logStats(std::string event, uint64_t key);
+    static bool hashFile(std::string path, uint64_t& hash);
+    static uint64_t hashFolder(std::string folder);
+    static uint64_t hashBytes(const void* data, size_t size, uint64_t seed);
+    static bool isSectionInside(uint64_t offset, uint64_t count, size_t elementSize, size_t fileSize);
+    static uint64_t getFieldValueCount(glm::ivec3 fieldSize);
+    static uint64_t alignOffset(uint64_t offset);
+};
+
+#endif
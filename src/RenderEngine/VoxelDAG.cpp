@@ -0,0 +1,198 @@
+#include "VoxelDAG.hpp"
+
+VoxelDAG::VoxelDAG() {
+    this->maxDepth = 0;
+    this->rootIndex = 0;
+    this->stats = {};
+}
+
+VoxelDAG::~VoxelDAG() {
+    clear();
+}
+
+bool VoxelDAG::NodeKey::operator==(const NodeKey& other) const {
+    if (childMask != other.childMask) return false;
+    for (uint32_t i = 0; i < 8; i++)
+        if (children[i] != other.children[i]) return false;
+    return true;
+}
+
+size_t VoxelDAG::NodeKeyHash::operator()(const NodeKey& key) const {
+    // FNV-1a over the mask and the child indices
+    uint64_t hash = 14695981039346656037ull;
+    hash = (hash ^ key.childMask) * 1099511628211ull;
+    for (uint32_t i = 0; i < 8; i++)
+        hash = (hash ^ key.children[i]) * 1099511628211ull;
+    return (size_t)hash;
+}
+
+void VoxelDAG::build(Octree* octree) {
+    clear();
+
+    ONode* root = octree->getRoot();
+    if (octree->isEmpty()) return;
+
+    bounds = root->getVoxel().aabb;
+    maxDepth = octree->getMaxDepth();
+
+    stats.levels.resize(maxDepth, {0, 0});
+    levelTables.resize(maxDepth);
+
+    // Post order walk, children are merged before their parent is hashed
+    rootIndex = mergeSubtree(root, 1);
+
+    for (uint32_t level = 0; level < maxDepth; level++) {
+        stats.levels[level].dagNodeCount = levelTables[level].size();
+        stats.treeNodeCount += stats.levels[level].treeNodeCount;
+    }
+    levelTables.clear();
+    levelTables.shrink_to_fit();
+
+    nodes.shrink_to_fit();
+    childPointers.shrink_to_fit();
+    normals.shrink_to_fit();
+    colors.shrink_to_fit();
+
+    stats.dagNodeCount = nodes.size();
+    stats.leafCount = normals.size();
+    stats.treeGeometryBytes = stats.treeNodeCount * sizeof(ChildDescriptor);
+    stats.dagGeometryBytes = nodes.size() * sizeof(DAGNode) + childPointers.size() * sizeof(uint32_t);
+    stats.attributeBytes = normals.size() * sizeof(glm::vec3) + colors.size() * sizeof(uint32_t);
+}
+
+uint32_t VoxelDAG::mergeSubtree(ONode* node, uint32_t depth) {
+    Voxel nodeVoxel = node->getVoxel();
+    stats.levels[depth - 1].treeNodeCount++;
+
+    NodeKey key = {};
+    uint32_t leafCount = 0;
+    if (node->children.size() == 0) {
+        // Every leaf shares the same geometry, only its attributes are kept apart
+        normals.push_back(nodeVoxel.normal);
+        colors.push_back(nodeVoxel.renderData);
+        leafCount = 1;
+    }
+    else {
+        ONode* octantChildren[8] = {nullptr};
+        for (ONode* child : node->children)
+            octantChildren[getAABBChildOctant(nodeVoxel.aabb, child->getVoxel().aabb)] = child;
+
+        // Children are visited in octant order so leaf attributes stay in traversal order
+        for (uint32_t octant = 0; octant < 8; octant++) {
+            if (octantChildren[octant] == nullptr) continue;
+
+            uint32_t childIndex = mergeSubtree(octantChildren[octant], depth + 1);
+            key.childMask |= 1 << octant;
+            key.children[octant] = childIndex;
+            leafCount += nodes[childIndex].leafCount;
+        }
+    }
+
+    auto& table = levelTables[depth - 1];
+    auto match = table.find(key);
+    if (match != table.end())
+        return match->second;
+
+    DAGNode dagNode = {
+        .firstChild = (uint32_t)childPointers.size(),
+        .leafCount = leafCount,
+        .childMask = (uint8_t)key.childMask,
+        .padding = {0, 0, 0}
+    };
+    for (uint32_t octant = 0; octant < 8; octant++)
+        if (key.childMask & (1 << octant))
+            childPointers.push_back(key.children[octant]);
+
+    uint32_t nodeIndex = (uint32_t)nodes.size();
+    nodes.push_back(dagNode);
+    table.emplace(key, nodeIndex);
+    return nodeIndex;
+}
+
+Mesh* VoxelDAG::compressToMesh(uint32_t depth) {
+    std::vector<VoxelVertex> vertices;
+    if (nodes.size() > 0)
+        traverseGettingLeaves(rootIndex, bounds, 1, depth, 0, vertices);
+
+    // Points are drawn in order, no index buffer
+    Mesh* volumeRenderMesh = new Mesh();
+    volumeRenderMesh->setVoxelVertices(vertices, depth);
+    return volumeRenderMesh;
+}
+
+void VoxelDAG::traverseGettingLeaves(uint32_t nodeIndex, AABB nodeAABB, uint32_t depth, uint32_t maxTraverseDepth, uint32_t leafIndex, std::vector<VoxelVertex>& vertices) {
+    if (depth > maxTraverseDepth || depth > maxDepth)
+        return;
+
+    const DAGNode& node = nodes[nodeIndex];
+    if (node.childMask == 0) {
+        // Is leaf
+        vertices.push_back(VoxelVertex::pack(getVoxelCell(bounds, maxTraverseDepth, nodeAABB.center), normals[leafIndex], colors[leafIndex]));
+        return;
+    }
+
+    uint32_t pointer = node.firstChild;
+    for (uint32_t octant = 0; octant < 8; octant++) {
+        if (!(node.childMask & (1 << octant))) continue;
+
+        uint32_t childIndex = childPointers[pointer++];
+        traverseGettingLeaves(childIndex, getAABBChild(nodeAABB, octant), depth + 1, maxTraverseDepth, leafIndex, vertices);
+        leafIndex += nodes[childIndex].leafCount;
+    }
+}
+
+std::vector<Mesh*> VoxelDAG::getDebugMeshes() {
+    std::vector<Mesh*> meshes;
+    if (nodes.size() > 0)
+        traverseGettingMeshes(rootIndex, bounds, 1, meshes);
+    return meshes;
+}
+
+void VoxelDAG::traverseGettingMeshes(uint32_t nodeIndex, AABB nodeAABB, uint32_t depth, std::vector<Mesh*>& meshes) {
+    float ratio = 2.0f * (depth - 1) / (maxDepth - 1);
+    float r = std::max(0.0f, ratio - 1.0f);
+    float b = std::max(0.0f, 1.0f - ratio);
+    float g = 1.0f - b - r;
+
+    meshes.push_back(Utils::getDebugBoxMesh(nodeAABB, glm::vec3(r, g, b)));
+
+    const DAGNode& node = nodes[nodeIndex];
+    uint32_t pointer = node.firstChild;
+    for (uint32_t octant = 0; octant < 8; octant++)
+        if (node.childMask & (1 << octant))
+            traverseGettingMeshes(childPointers[pointer++], getAABBChild(nodeAABB, octant), depth + 1, meshes);
+}
+
+AABB VoxelDAG::getBounds() {
+    return bounds;
+}
+
+uint32_t VoxelDAG::getMaxDepth() {
+    return maxDepth;
+}
+
+size_t VoxelDAG::getNodeCount() {
+    return nodes.size();
+}
+
+size_t VoxelDAG::getLeafCount() {
+    return normals.size();
+}
+
+size_t VoxelDAG::getMemoryUsage() {
+    return stats.dagGeometryBytes + stats.attributeBytes;
+}
+
+DAGCompressionStats VoxelDAG::getCompressionStats() {
+    return stats;
+}
+
+void VoxelDAG::clear() {
+    nodes.clear();
+    childPointers.clear();
+    normals.clear();
+    colors.clear();
+    levelTables.clear();
+    stats = {};
+    rootIndex = 0;
+}
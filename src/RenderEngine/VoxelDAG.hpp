@@ -0,0 +1,99 @@
+#ifndef _VOXEL_DAG_HPP_
+#define _VOXEL_DAG_HPP_
+
+#include <stdint.h>
+#include <vector>
+#include <unordered_map>
+#include <glm/glm.hpp>
+
+#include "Octree.hpp"
+#include "LinearOctree.hpp"
+#include "Utils.hpp"
+#include "Geometry.hpp"
+
+/*
+    DAG NODE
+    96 bits
+
+    | firstChild (32) | leafCount (32) | childMask (8) | padding (24) |
+
+    Only the geometry is stored in the graph. Children are indices into the
+    node array, listed in childPointers starting at firstChild, one per octant
+    set in childMask (| y | z | x | order, as in the Octree). Identical subtrees
+    share a single node, so a node may have many parents.
+
+    Leaf attributes live in separate arrays in depth first octant order. A leaf's
+    attribute index is the sum of the leafCount of every sibling subtree visited
+    before it, which is the same for every parent sharing the subtree.
+*/
+struct DAGNode {
+    uint32_t firstChild;
+    uint32_t leafCount;
+    uint8_t childMask;
+    uint8_t padding[3];
+};
+
+struct DAGLevelStats {
+    size_t treeNodeCount;
+    size_t dagNodeCount;
+};
+
+struct DAGCompressionStats {
+    std::vector<DAGLevelStats> levels;
+    size_t treeNodeCount;
+    size_t dagNodeCount;
+    size_t leafCount;
+    // Geometry of the same tree in the LinearOctree layout
+    size_t treeGeometryBytes;
+    size_t dagGeometryBytes;
+    size_t attributeBytes;
+};
+
+class VoxelDAG {
+public:
+    VoxelDAG();
+    ~VoxelDAG();
+
+    void build(Octree* octree);
+    Mesh* compressToMesh(uint32_t depth);
+    std::vector<Mesh*> getDebugMeshes();
+    AABB getBounds();
+    uint32_t getMaxDepth();
+    size_t getNodeCount();
+    size_t getLeafCount();
+    size_t getMemoryUsage();
+    DAGCompressionStats getCompressionStats();
+private:
+    // Mask and child indices of a node, the identity used to merge subtrees
+    struct NodeKey {
+        uint32_t childMask;
+        uint32_t children[8];
+
+        bool operator==(const NodeKey& other) const;
+    };
+
+    struct NodeKeyHash {
+        size_t operator()(const NodeKey& key) const;
+    };
+
+    AABB bounds;
+    uint32_t maxDepth;
+    uint32_t rootIndex;
+
+    std::vector<DAGNode> nodes;
+    std::vector<uint32_t> childPointers;
+    std::vector<glm::vec3> normals;
+    std::vector<uint32_t> colors;
+
+    // One table per depth, subtrees are only merged within their level
+    std::vector<std::unordered_map<NodeKey, uint32_t, NodeKeyHash>> levelTables;
+    DAGCompressionStats stats;
+
+    void clear();
+    uint32_t mergeSubtree(ONode* node, uint32_t depth);
+
+    void traverseGettingLeaves(uint32_t nodeIndex, AABB nodeAABB, uint32_t depth, uint32_t maxTraverseDepth, uint32_t leafIndex, std::vector<VoxelVertex>& vertices);
+    void traverseGettingMeshes(uint32_t nodeIndex, AABB nodeAABB, uint32_t depth, std::vector<Mesh*>& meshes);
+};
+
+#endif
@@ -0,0 +1,179 @@
+#include "VoxelPyramid.hpp"
+
+VoxelPyramid::VoxelPyramid() {
+    this->bounds = {
+        .min = glm::vec3(0.0f),
+        .max = glm::vec3(0.0f),
+        .center = glm::vec3(0.0f)
+    };
+    this->maxDepth = 0;
+}
+
+void VoxelPyramid::build(const std::vector<Voxel>& voxels, ThreadPool* pool) {
+    levels.clear();
+    bounds = getVoxelBounds(voxels);
+    maxDepth = 0;
+    if (voxels.size() == 0) return;
+
+    // Voxels are one unit apart, so a grid at least as wide as the widest extent keeps them apart
+    glm::vec3 rootSize = bounds.max - bounds.min;
+    uint32_t extent = (uint32_t)std::ceil(std::max(rootSize.x, std::max(rootSize.y, rootSize.z))) + 1;
+    maxDepth = std::min((uint32_t)std::bit_width(extent - 1) + 1, (uint32_t)MORTON_MAX_LEVELS + 1);
+
+    // Quantize every voxel position into the deepest level, the same way the Morton octree builder does
+    uint32_t gridSize = 1u << (maxDepth - 1);
+    glm::vec3 cellScale = glm::vec3((float)gridSize) / rootSize;
+    std::vector<MortonVoxel> mortonVoxels(voxels.size());
+    for (size_t first = 0; first < voxels.size(); first += VOXEL_PYRAMID_TASK_CELLS)
+        pool->submit([&voxels, &mortonVoxels, first, gridSize, cellScale, this]() {
+            size_t last = std::min(first + VOXEL_PYRAMID_TASK_CELLS, voxels.size());
+            for (size_t i = first; i < last; i++) {
+                glm::uvec3 cell = glm::uvec3((voxels[i].position - bounds.min) * cellScale);
+                cell = glm::min(cell, glm::uvec3(gridSize - 1));
+                mortonVoxels[i] = {Morton::encode(cell), (uint32_t)i};
+            }
+        });
+    pool->wait();
+    Morton::radixSort(mortonVoxels, 3 * (maxDepth - 1));
+
+    std::vector<VoxelPyramidCell> leaves(voxels.size());
+    for (size_t first = 0; first < voxels.size(); first += VOXEL_PYRAMID_TASK_CELLS)
+        pool->submit([&voxels, &mortonVoxels, &leaves, first]() {
+            size_t last = std::min(first + VOXEL_PYRAMID_TASK_CELLS, voxels.size());
+            for (size_t i = first; i < last; i++) {
+                const Voxel& voxel = voxels[mortonVoxels[i].index];
+                leaves[i] = {
+                    .code = mortonVoxels[i].code,
+                    .voxelCount = 1,
+                    .normalSum = voxel.normal,
+                    .colorSum = unpackVoxelColor(voxel.renderData)
+                };
+            }
+        });
+    pool->wait();
+
+    // Voxels sharing a deepest cell are merged first, then every level halves the one below
+    levels.resize(maxDepth);
+    levels[maxDepth - 1] = reduceLevel(leaves, 0, pool);
+    for (uint32_t depth = maxDepth - 1; depth >= 1; depth--)
+        levels[depth - 1] = reduceLevel(levels[depth], 3, pool);
+}
+
+const std::vector<VoxelPyramidCell>& VoxelPyramid::getLevel(uint32_t depth) {
+    static const std::vector<VoxelPyramidCell> emptyLevel;
+    if (maxDepth == 0) return emptyLevel;
+    return levels[std::clamp(depth, 1u, maxDepth) - 1];
+}
+
+std::vector<Voxel> VoxelPyramid::getVoxels(uint32_t depth) {
+    depth = std::clamp(depth, 1u, std::max(maxDepth, 1u));
+    const std::vector<VoxelPyramidCell>& level = getLevel(depth);
+    std::vector<Voxel> voxels(level.size());
+    for (size_t i = 0; i < level.size(); i++) {
+        const VoxelPyramidCell& cell = level[i];
+        voxels[i].aabb = getCellAABB(depth, cell.code);
+        voxels[i].position = voxels[i].aabb.center;
+        voxels[i].normal = glm::length(cell.normalSum) > 0.0f ? glm::normalize(cell.normalSum) : cell.normalSum;
+        voxels[i].renderData = packVoxelColor(cell.colorSum / (float)cell.voxelCount);
+    }
+    return voxels;
+}
+
+Mesh* VoxelPyramid::compressToMesh(uint32_t depth) {
+    // One point per cell, like the octree leaves, so the voxel pipeline draws any level as is
+    std::vector<Voxel> voxels = getVoxels(depth);
+    std::vector<VoxelVertex> vertices(voxels.size());
+    for (uint32_t i = 0; i < voxels.size(); i++)
+        vertices[i] = VoxelVertex::pack(getVoxelCell(bounds, depth, voxels[i].position), voxels[i].normal, voxels[i].renderData);
+
+    Mesh* volumeRenderMesh = new Mesh();
+    volumeRenderMesh->setVoxelVertices(vertices, depth);
+    return volumeRenderMesh;
+}
+
+AABB VoxelPyramid::getBounds() {
+    return bounds;
+}
+
+uint32_t VoxelPyramid::getMaxDepth() {
+    return maxDepth;
+}
+
+size_t VoxelPyramid::getCellCount() {
+    size_t cellCount = 0;
+    for (const std::vector<VoxelPyramidCell>& level : levels)
+        cellCount += level.size();
+    return cellCount;
+}
+
+size_t VoxelPyramid::getMemoryUsage() {
+    size_t memoryUsage = 0;
+    for (const std::vector<VoxelPyramidCell>& level : levels)
+        memoryUsage += level.capacity() * sizeof(VoxelPyramidCell);
+    return memoryUsage;
+}
+
+AABB VoxelPyramid::getCellAABB(uint32_t depth, uint64_t code) {
+    glm::vec3 cellSize = (bounds.max - bounds.min) / (float)(1u << (depth - 1));
+    AABB cellAABB;
+    cellAABB.min = bounds.min + glm::vec3(Morton::decode(code)) * cellSize;
+    cellAABB.max = cellAABB.min + cellSize;
+    cellAABB.center = (cellAABB.min + cellAABB.max) / 2.0f;
+    return cellAABB;
+}
+
+std::vector<VoxelPyramidCell> VoxelPyramid::reduceLevel(const std::vector<VoxelPyramidCell>& cells, uint32_t shift, ThreadPool* pool) {
+    // Ranges start where the parent code changes, so every parent is summed by one task
+    std::vector<size_t> rangeStarts = {0};
+    for (size_t start = VOXEL_PYRAMID_TASK_CELLS; start < cells.size(); start += VOXEL_PYRAMID_TASK_CELLS) {
+        while (start < cells.size() && (cells[start].code >> shift) == (cells[start - 1].code >> shift))
+            start++;
+        if (start < cells.size())
+            rangeStarts.push_back(start);
+    }
+    rangeStarts.push_back(cells.size());
+    size_t rangeCount = rangeStarts.size() - 1;
+
+    // The first pass counts the parents of every range, the second sums them in place
+    std::vector<size_t> parentOffsets(rangeCount + 1, 0);
+    for (size_t range = 0; range < rangeCount; range++)
+        pool->submit([&cells, &rangeStarts, &parentOffsets, shift, range]() {
+            parentOffsets[range + 1] = reduceRange(cells, shift, rangeStarts[range], rangeStarts[range + 1], nullptr);
+        });
+    pool->wait();
+    for (size_t range = 0; range < rangeCount; range++)
+        parentOffsets[range + 1] += parentOffsets[range];
+
+    std::vector<VoxelPyramidCell> parents(parentOffsets.back());
+    for (size_t range = 0; range < rangeCount; range++)
+        pool->submit([&cells, &rangeStarts, &parentOffsets, &parents, shift, range]() {
+            reduceRange(cells, shift, rangeStarts[range], rangeStarts[range + 1], parents.data() + parentOffsets[range]);
+        });
+    pool->wait();
+    return parents;
+}
+
+size_t VoxelPyramid::reduceRange(const std::vector<VoxelPyramidCell>& cells, uint32_t shift, size_t begin, size_t end, VoxelPyramidCell* parents) {
+    // Counts the parents of the range and, given somewhere to write them, sums their cells
+    size_t parentCount = 0;
+    for (size_t i = begin; i < end; i++) {
+        uint64_t parentCode = cells[i].code >> shift;
+        if (i == begin || parentCode != (cells[i - 1].code >> shift)) {
+            if (parents != nullptr)
+                parents[parentCount] = {
+                    .code = parentCode,
+                    .voxelCount = 0,
+                    .normalSum = glm::vec3(0.0f),
+                    .colorSum = glm::vec3(0.0f)
+                };
+            parentCount++;
+        }
+        if (parents == nullptr) continue;
+
+        VoxelPyramidCell& parent = parents[parentCount - 1];
+        parent.voxelCount += cells[i].voxelCount;
+        parent.normalSum += cells[i].normalSum;
+        parent.colorSum += cells[i].colorSum;
+    }
+    return parentCount;
+}
@@ -0,0 +1,57 @@
+#ifndef _VOXEL_PYRAMID_HPP_
+#define _VOXEL_PYRAMID_HPP_
+
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <bit>
+#include <glm/glm.hpp>
+
+#include "Morton.hpp"
+#include "ThreadPool.hpp"
+#include "Mesh.hpp"
+#include "Geometry.hpp"
+
+// Cells reduced by one pool task, rounded up to whole sibling runs
+#define VOXEL_PYRAMID_TASK_CELLS 16384
+
+// Occupied cell of one pyramid level. Sums run over every voxel inside the cell
+struct VoxelPyramidCell {
+    uint64_t code;
+    uint32_t voxelCount;
+    glm::vec3 normalSum;
+    glm::vec3 colorSum;
+};
+
+/*
+    Every level of detail of a voxel set, in the octree frame: depth d splits
+    the voxel bounds into 2^(d - 1) cells per axis, like Octree::buildMorton.
+    The deepest level is fine enough to give every voxel its own cell, and each
+    level above is a 2x2x2 reduction of the one below. Cells are sorted by
+    Morton code, so the children of a cell are one run of the level below.
+*/
+class VoxelPyramid {
+public:
+    VoxelPyramid();
+
+    void build(const std::vector<Voxel>& voxels, ThreadPool* pool);
+    const std::vector<VoxelPyramidCell>& getLevel(uint32_t depth);
+    std::vector<Voxel> getVoxels(uint32_t depth);
+    Mesh* compressToMesh(uint32_t depth);
+    AABB getBounds();
+    uint32_t getMaxDepth();
+    size_t getCellCount();
+    size_t getMemoryUsage();
+private:
+    AABB bounds;
+    uint32_t maxDepth;
+    // levels[depth - 1]
+    std::vector<std::vector<VoxelPyramidCell>> levels;
+
+    AABB getCellAABB(uint32_t depth, uint64_t code);
+    static std::vector<VoxelPyramidCell> reduceLevel(const std::vector<VoxelPyramidCell>& cells, uint32_t shift, ThreadPool* pool);
+    static size_t reduceRange(const std::vector<VoxelPyramidCell>& cells, uint32_t shift, size_t begin, size_t end, VoxelPyramidCell* parents);
+};
+
+#endif
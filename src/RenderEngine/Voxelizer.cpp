@@ -2,22 +2,163 @@
 
 int Voxelizer::scale = 60;
 int Voxelizer::density = 20;
+int Voxelizer::mode = VOXELIZATION_CONSERVATIVE;
+int Voxelizer::threadCount = ThreadPool::getHardwareThreadCount();
+int Voxelizer::seed = 0;
+int Voxelizer::meshing = VOLUME_MESHING_GREEDY;
 
-Volume Voxelizer::voxelizeMesh(Mesh* mesh) {
+SampleRandom::SampleRandom(uint64_t seed) {
+    // splitmix64 spreads the seed over every lane's state
+    for (uint32_t lane = 0; lane < VOXELIZER_SAMPLE_LANES; lane++) {
+        for (uint32_t i = 0; i < 4; i++) {
+            seed += 0x9E3779B97F4A7C15ull;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            state[i][lane] = (uint32_t)((z ^ (z >> 31)) >> 32);
+        }
+    }
+}
+
+void SampleRandom::next(float* values) {
+    for (uint32_t lane = 0; lane < VOXELIZER_SAMPLE_LANES; lane++) {
+        uint32_t result = state[0][lane] + state[3][lane];
+        uint32_t t = state[1][lane] << 9;
+
+        state[2][lane] ^= state[0][lane];
+        state[3][lane] ^= state[1][lane];
+        state[1][lane] ^= state[2][lane];
+        state[0][lane] ^= state[3][lane];
+        state[2][lane] ^= t;
+        state[3][lane] = (state[3][lane] << 11) | (state[3][lane] >> 21);
+
+        // The top 24 bits fill the float mantissa
+        values[lane] = (float)(result >> 8) * (1.0f / 16777216.0f);
+    }
+}
+
+Volume Voxelizer::voxelizeMesh(Mesh* mesh, ImageCache* imageCache) {
     normalizeMesh(mesh);
-    std::vector<Voxel> voxels = getMeshSurfacePoints(mesh);
-    removeDuplicatedVoxels(voxels);
+
+    // Without the texture pool's cache the images are decoded for this call only
+    ImageCache localImageCache;
+    if (imageCache == nullptr)
+        imageCache = &localImageCache;
+
+    // Positions and UVs are all the voxelizer reads from the vertices
+    std::vector<Vertex> vertices = mesh->getVertices();
+    std::vector<uint32_t> indices = mesh->getIndices();
+    std::vector<glm::vec3> positions(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++)
+        positions[i] = vertices[i].position;
+    VoxelMaterials materials = getMeshMaterials(mesh, vertices, imageCache);
+    vertices.clear();
+    vertices.shrink_to_fit();
+
+    ThreadPool pool(std::max(threadCount, 1));
+    std::vector<std::vector<VoxelSample>> batchSamples;
+    if (mode == VOXELIZATION_SAMPLING)
+        batchSamples = getMeshSurfacePoints(positions, indices, materials, 0, &pool);
+    else
+        batchSamples = getMeshOverlappedCells(positions, indices, materials, &pool);
+    std::vector<Voxel> voxels = mergeSamples(batchSamples, getTriangleNormals(positions, indices), &pool);
 
     Volume volume = {
         .scale = scale,
         .voxels = voxels
     };
 
+    // The surface stays the voxel list, the filled volume is only kept as spans
+    if (mode == VOXELIZATION_SOLID || mode == VOXELIZATION_SIGNED_DISTANCE)
+        volume.solidSpans = fillSolid(positions, indices, volume.voxels, &pool);
+    if (mode == VOXELIZATION_SIGNED_DISTANCE)
+        volume.distanceField = getDistanceField(positions, indices, volume.voxels, volume.solidSpans, &pool);
+    buildPyramid(volume, &pool);
+
     return volume;
 }
 
+Volume Voxelizer::voxelizeOBJFile(std::string OBJPath) {
+    // First pass over the file for the bounds normalizeMesh would use
+    OBJStream stream(OBJPath);
+    Volume volume = {
+        .scale = scale,
+        .voxels = std::vector<Voxel>()
+    };
+    if (!stream.readVertices()) return volume;
+    glm::mat4 normalization = getNormalizationMatrix(stream.getBounds());
+
+    // Second pass, every chunk is voxelized into the sparse cell store and dropped.
+    // The stream reads no materials, so streamed voxels keep the default color
+    ThreadPool pool(std::max(threadCount, 1));
+    std::unordered_map<glm::ivec3, VoxelCellSum> cellSums;
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    uint32_t chunkCount = 0;
+    size_t streamedTriangles = 0;
+    while (stream.readTriangles(positions, VOXELIZER_STREAM_CHUNK)) {
+        for (glm::vec3& position : positions)
+            position = glm::vec3(normalization * glm::vec4(position, 1.0f));
+        indices.resize(positions.size());
+        for (uint32_t i = 0; i < indices.size(); i++)
+            indices[i] = i;
+        VoxelMaterials materials = getDefaultMaterials(positions.size() / 3);
+
+        // Chunks before the last are full, so their batches line up with those of voxelizeMesh
+        std::vector<std::vector<VoxelSample>> batchSamples;
+        if (mode == VOXELIZATION_SAMPLING)
+            batchSamples = getMeshSurfacePoints(positions, indices, materials, streamedTriangles / VOXELIZER_TRIANGLE_BATCH, &pool);
+        else
+            batchSamples = getMeshOverlappedCells(positions, indices, materials, &pool);
+        accumulateSamples(batchSamples, getTriangleNormals(positions, indices), cellSums);
+        streamedTriangles += positions.size() / 3;
+        chunkCount++;
+    }
+
+    positions = std::vector<glm::vec3>();
+    indices = std::vector<uint32_t>();
+    volume.voxels = getAccumulatedVoxels(cellSums);
+
+    // Map nodes hold the cell, the sums and the bucket chain pointer
+    size_t storeBytes = cellSums.bucket_count() * sizeof(void*) + cellSums.size() * (sizeof(std::pair<glm::ivec3, VoxelCellSum>) + sizeof(void*));
+    spdlog::info("Streamed " + std::to_string(stream.getTriangleCount()) + " triangles of " + OBJPath + " in " + std::to_string(chunkCount) + " chunks into " + std::to_string(volume.voxels.size()) + " voxels. Cell store of " + std::to_string(storeBytes / (1024 * 1024)) + " MB.");
+    cellSums.clear();
+
+    // Parity needs every triangle at once, so streamed solids are filled from the outside.
+    // So do exact distances, streamed volumes stop at the solid
+    if (mode == VOXELIZATION_SOLID || mode == VOXELIZATION_SIGNED_DISTANCE)
+        volume.solidSpans = fillSolid(std::vector<glm::vec3>(), std::vector<uint32_t>(), volume.voxels, &pool);
+    if (mode == VOXELIZATION_SIGNED_DISTANCE)
+        spdlog::warn("Signed distance fields need the whole mesh in memory, " + OBJPath + " was only voxelized as a solid.");
+    buildPyramid(volume, &pool);
+
+    return volume;
+}
+
+void Voxelizer::buildPyramid(Volume& volume, ThreadPool* pool) {
+    // Volumes from elsewhere, like the cache, build theirs without a voxelization pool
+    std::unique_ptr<ThreadPool> localPool;
+    if (pool == nullptr) {
+        localPool = std::make_unique<ThreadPool>(std::max(threadCount, 1));
+        pool = localPool.get();
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+    volume.pyramid = std::make_shared<VoxelPyramid>();
+    volume.pyramid->build(volume.voxels, pool);
+    double pyramidTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+    std::string levelSizes;
+    for (uint32_t depth = 1; depth <= volume.pyramid->getMaxDepth(); depth++)
+        levelSizes += (depth > 1 ? " / " : "") + std::to_string(volume.pyramid->getLevel(depth).size());
+    spdlog::info("Voxel pyramid of " + std::to_string(volume.pyramid->getMaxDepth()) + " levels (" + levelSizes + " cells, " + std::to_string(volume.pyramid->getMemoryUsage() / 1024) + " KB) built in " + std::to_string(pyramidTime) + " ms.");
+}
+
 void Voxelizer::normalizeMesh(Mesh* mesh) {
-    AABB meshBounds = mesh->getBoundingBox();
+    mesh->translateByMatrix(getNormalizationMatrix(mesh->getBoundingBox()));
+}
+
+glm::mat4 Voxelizer::getNormalizationMatrix(AABB meshBounds) {
     glm::vec3 boundSize = {
         std::abs(meshBounds.min.x - meshBounds.max.x),
         std::abs(meshBounds.min.y - meshBounds.max.y),
@@ -39,62 +180,909 @@ void Voxelizer::normalizeMesh(Mesh* mesh) {
     translationMatrix = glm::translate(translationMatrix, normalizedCenter);
 
     glm::mat4 finalMatrix = scaleMatrix * translationMatrix;
-    mesh->translateByMatrix(finalMatrix);
+    return finalMatrix;
 }
 
-std::vector<Voxel> Voxelizer::getMeshSurfacePoints(Mesh* mesh) {
-    std::vector<Vertex> vertices = mesh->getVertices();
+std::vector<std::vector<VoxelSample>> Voxelizer::getMeshSurfacePoints(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const VoxelMaterials& materials, uint32_t firstBatch, ThreadPool* pool) {
+    uint32_t triangleCount = indices.size() / 3;
+    uint32_t batchCount = (triangleCount + VOXELIZER_TRIANGLE_BATCH - 1) / VOXELIZER_TRIANGLE_BATCH;
+    auto startTime = std::chrono::steady_clock::now();
+    std::vector<std::vector<VoxelSample>> batchSamples(batchCount);
+    for (uint32_t batch = 0; batch < batchCount; batch++)
+        pool->submit([&positions, &indices, &materials, firstBatch, batch, &batchSamples]() {
+            sampleTriangleBatch(positions, indices, materials, batch, firstBatch, batchSamples[batch]);
+        });
+    pool->wait();
+
+    double sampleTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    size_t sampleCount = 0;
+    for (const std::vector<VoxelSample>& samples : batchSamples)
+        sampleCount += samples.size();
+    spdlog::info(std::to_string(sampleCount) + " surface samples in " + std::to_string(sampleTime) + " ms (" + std::to_string(sampleCount / sampleTime / 1e3) + " Msamples/s).");
+    return batchSamples;
+}
+
+void Voxelizer::sampleTriangleBatch(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const VoxelMaterials& materials, uint32_t batchIndex, uint32_t firstBatch, std::vector<VoxelSample>& samples) {
+    // Seeded per batch, so the points are the same for any thread count. Streamed
+    // chunks number their batches after the previous chunks
+    SampleRandom random(((uint64_t)(uint32_t)seed << 32) | (firstBatch + batchIndex));
+    float lambdas[VOXELIZER_SAMPLE_LANES], mus[VOXELIZER_SAMPLE_LANES];
+    float us[VOXELIZER_SAMPLE_LANES], vs[VOXELIZER_SAMPLE_LANES];
+    int cellsX[VOXELIZER_SAMPLE_LANES], cellsY[VOXELIZER_SAMPLE_LANES], cellsZ[VOXELIZER_SAMPLE_LANES];
+
+    uint32_t firstIndex = batchIndex * VOXELIZER_TRIANGLE_BATCH * 3;
+    uint32_t lastIndex = std::min<size_t>(firstIndex + VOXELIZER_TRIANGLE_BATCH * 3, indices.size() - indices.size() % 3);
+    for (uint32_t i = firstIndex; i < lastIndex; i += 3) {
+        glm::vec3 v0 = positions[indices[i + 0]];
+        glm::vec3 v1 = positions[indices[i + 1]];
+        glm::vec3 v2 = positions[indices[i + 2]];
+        glm::vec3 edge0 = v1 - v0;
+        glm::vec3 edge1 = v2 - v1;
+
+        float area = glm::length(glm::cross(edge0, v2 - v0)) / 2.0f;
+        uint32_t numPoints = std::round(density * area);
+        if (numPoints == 0) continue;
+
+        // UVs follow the same barycentrics as the position
+        uint32_t material = materials.triangleMaterials[i / 3];
+        glm::vec2 uv0 = glm::vec2(0.0f), uvEdge0 = glm::vec2(0.0f), uvEdge1 = glm::vec2(0.0f);
+        if (materials.diffuseMaps[material] != nullptr) {
+            uv0 = materials.uvs[indices[i + 0]];
+            uvEdge0 = materials.uvs[indices[i + 1]] - uv0;
+            uvEdge1 = materials.uvs[indices[i + 2]] - materials.uvs[indices[i + 1]];
+        }
+
+        size_t firstSample = samples.size();
+        samples.resize(firstSample + numPoints);
+        for (uint32_t j = 0; j < numPoints; j += VOXELIZER_SAMPLE_LANES) {
+            random.next(lambdas);
+            random.next(mus);
+
+            // v0 + sqrt(r1) * (v1 - v0) + sqrt(r1) * r2 * (v2 - v1) is uniform over the triangle
+            for (uint32_t lane = 0; lane < VOXELIZER_SAMPLE_LANES; lane++) {
+                float lambda = std::sqrt(lambdas[lane]);
+                float lambdaMu = lambda * mus[lane];
+                cellsX[lane] = (int)std::floor(v0.x + lambda * edge0.x + lambdaMu * edge1.x);
+                cellsY[lane] = (int)std::floor(v0.y + lambda * edge0.y + lambdaMu * edge1.y);
+                cellsZ[lane] = (int)std::floor(v0.z + lambda * edge0.z + lambdaMu * edge1.z);
+                us[lane] = uv0.x + lambda * uvEdge0.x + lambdaMu * uvEdge1.x;
+                vs[lane] = uv0.y + lambda * uvEdge0.y + lambdaMu * uvEdge1.y;
+            }
+
+            uint32_t laneCount = std::min<uint32_t>(VOXELIZER_SAMPLE_LANES, numPoints - j);
+            for (uint32_t lane = 0; lane < laneCount; lane++) {
+                VoxelSample& sample = samples[firstSample + j + lane];
+                sample.cell = glm::ivec3(cellsX[lane], cellsY[lane], cellsZ[lane]);
+                sample.triangle = i / 3;
+            }
+            colorSamples(materials, material, us, vs, &samples[firstSample + j], laneCount);
+        }
+    }
+}
+
+std::vector<std::vector<VoxelSample>> Voxelizer::getMeshOverlappedCells(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const VoxelMaterials& materials, ThreadPool* pool) {
+    uint32_t triangleCount = indices.size() / 3;
+    uint32_t batchCount = (triangleCount + VOXELIZER_TRIANGLE_BATCH - 1) / VOXELIZER_TRIANGLE_BATCH;
+    std::vector<std::vector<VoxelSample>> batchSamples(batchCount);
+    for (uint32_t batch = 0; batch < batchCount; batch++)
+        pool->submit([&positions, &indices, &materials, batch, &batchSamples]() {
+            overlapTriangleBatch(positions, indices, materials, batch, batchSamples[batch]);
+        });
+    pool->wait();
+    return batchSamples;
+}
+
+void Voxelizer::overlapTriangleBatch(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const VoxelMaterials& materials, uint32_t batchIndex, std::vector<VoxelSample>& samples) {
+    uint32_t firstIndex = batchIndex * VOXELIZER_TRIANGLE_BATCH * 3;
+    uint32_t lastIndex = std::min<size_t>(firstIndex + VOXELIZER_TRIANGLE_BATCH * 3, indices.size() - indices.size() % 3);
+    std::vector<float> us, vs;
+
+    // One sample per overlapped cell, cells shared by several triangles are merged later
+    for (uint32_t i = firstIndex; i < lastIndex; i += 3) {
+        glm::vec3 v0 = positions[indices[i + 0]];
+        glm::vec3 v1 = positions[indices[i + 1]];
+        glm::vec3 v2 = positions[indices[i + 2]];
+
+        if (glm::length(glm::cross(v1 - v0, v2 - v0)) == 0.0f) continue;
+
+        // Cells are colored at the barycentrics of their center projected on the
+        // triangle, clamped inside it
+        uint32_t material = materials.triangleMaterials[i / 3];
+        bool textured = materials.diffuseMaps[material] != nullptr;
+        glm::vec3 edge0 = v1 - v0;
+        glm::vec3 edge1 = v2 - v0;
+        float d00 = glm::dot(edge0, edge0);
+        float d01 = glm::dot(edge0, edge1);
+        float d11 = glm::dot(edge1, edge1);
+        float denominator = d00 * d11 - d01 * d01;
+        size_t firstSample = samples.size();
+        us.clear();
+        vs.clear();
+
+        // Only the cells in the triangle's bounds are tested
+        glm::ivec3 minCell = glm::ivec3(glm::floor(glm::min(v0, glm::min(v1, v2))));
+        glm::ivec3 maxCell = glm::ivec3(glm::floor(glm::max(v0, glm::max(v1, v2))));
+        for (int y = minCell.y; y <= maxCell.y; y++) {
+            for (int z = minCell.z; z <= maxCell.z; z++) {
+                for (int x = minCell.x; x <= maxCell.x; x++) {
+                    AABB cell;
+                    cell.min = glm::vec3(x, y, z);
+                    cell.max = cell.min + glm::vec3(1.0f);
+                    cell.center = cell.min + glm::vec3(0.5f);
+                    if (!isTriangleIntersectingAABB(v0, v1, v2, cell)) continue;
+
+                    VoxelSample sample;
+                    sample.cell = glm::ivec3(x, y, z);
+                    sample.triangle = i / 3;
+                    samples.push_back(sample);
+                    if (!textured) continue;
+
+                    glm::vec3 offset = cell.center - v0;
+                    float d20 = glm::dot(offset, edge0);
+                    float d21 = glm::dot(offset, edge1);
+                    glm::vec3 barycentrics;
+                    barycentrics.y = std::max((d11 * d20 - d01 * d21) / denominator, 0.0f);
+                    barycentrics.z = std::max((d00 * d21 - d01 * d20) / denominator, 0.0f);
+                    barycentrics.x = std::max(1.0f - barycentrics.y - barycentrics.z, 0.0f);
+                    barycentrics /= barycentrics.x + barycentrics.y + barycentrics.z;
+
+                    glm::vec2 uv = barycentrics.x * materials.uvs[indices[i + 0]] + barycentrics.y * materials.uvs[indices[i + 1]] + barycentrics.z * materials.uvs[indices[i + 2]];
+                    us.push_back(uv.x);
+                    vs.push_back(uv.y);
+                }
+            }
+        }
+
+        // Colored a lane group at a time, the tail reads padding
+        uint32_t cellCount = samples.size() - firstSample;
+        us.resize(cellCount + VOXELIZER_SAMPLE_LANES, 0.0f);
+        vs.resize(cellCount + VOXELIZER_SAMPLE_LANES, 0.0f);
+        for (uint32_t j = 0; j < cellCount; j += VOXELIZER_SAMPLE_LANES)
+            colorSamples(materials, material, &us[j], &vs[j], &samples[firstSample + j], std::min<uint32_t>(VOXELIZER_SAMPLE_LANES, cellCount - j));
+    }
+}
+
+void Voxelizer::colorSamples(const VoxelMaterials& materials, uint32_t material, const float* us, const float* vs, VoxelSample* samples, uint32_t sampleCount) {
+    uint32_t colors[VOXELIZER_SAMPLE_LANES];
+    const ImageData* diffuseMap = materials.diffuseMaps[material];
+    if (diffuseMap != nullptr)
+        lookupTexels(diffuseMap, us, vs, colors);
+    else
+        std::fill(colors, colors + VOXELIZER_SAMPLE_LANES, materials.diffuseColors[material]);
+
+    for (uint32_t lane = 0; lane < sampleCount; lane++)
+        samples[lane].color = colors[lane];
+}
+
+void Voxelizer::lookupTexels(const ImageData* image, const float* us, const float* vs, uint32_t* colors) {
+    // Nearest texel with repeat wrapping, averaging the cell's samples does the filtering
+    const uint32_t* texels = (const uint32_t*)image->data.data();
+    int width = image->width;
+    int height = image->height;
+
+#if defined(__AVX2__)
+    // One gather for the whole lane group, the compiler does not emit it on its own
+    __m256 u = _mm256_loadu_ps(us);
+    __m256 v = _mm256_loadu_ps(vs);
+    u = _mm256_sub_ps(u, _mm256_floor_ps(u));
+    v = _mm256_sub_ps(v, _mm256_floor_ps(v));
+    __m256i x = _mm256_min_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(u, _mm256_set1_ps((float)width))), _mm256_set1_epi32(width - 1));
+    __m256i y = _mm256_min_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(v, _mm256_set1_ps((float)height))), _mm256_set1_epi32(height - 1));
+    __m256i texel = _mm256_i32gather_epi32((const int*)texels, _mm256_add_epi32(_mm256_mullo_epi32(y, _mm256_set1_epi32(width)), x), 4);
+
+    // RGBA bytes to | R | G | B |, the alpha byte is cleared
+    __m256i swizzle = _mm256_setr_epi8(
+        2, 1, 0, -1, 6, 5, 4, -1, 10, 9, 8, -1, 14, 13, 12, -1,
+        2, 1, 0, -1, 6, 5, 4, -1, 10, 9, 8, -1, 14, 13, 12, -1
+    );
+    _mm256_storeu_si256((__m256i*)colors, _mm256_shuffle_epi8(texel, swizzle));
+#else
+    for (uint32_t lane = 0; lane < VOXELIZER_SAMPLE_LANES; lane++) {
+        float u = us[lane] - std::floor(us[lane]);
+        float v = vs[lane] - std::floor(vs[lane]);
+        int x = std::min((int)(u * width), width - 1);
+        int y = std::min((int)(v * height), height - 1);
+        uint32_t texel = texels[y * width + x];
+
+        // RGBA bytes to | R | G | B |
+        colors[lane] = ((texel & 0xFF) << 16) | (texel & 0xFF00) | ((texel >> 16) & 0xFF);
+    }
+#endif
+}
+
+VoxelMaterials Voxelizer::getMeshMaterials(Mesh* mesh, const std::vector<Vertex>& vertices, ImageCache* imageCache) {
     std::vector<uint32_t> indices = mesh->getIndices();
+    std::vector<Material> meshMaterials = mesh->getMaterials();
+    if (meshMaterials.empty())
+        return getDefaultMaterials(indices.size() / 3);
+
+    // Materials cover consecutive index ranges, in order, like the draw calls use them
+    VoxelMaterials materials;
+    materials.triangleMaterials = std::vector<uint32_t>(indices.size() / 3, 0);
+    uint32_t firstIndex = 0;
+    bool textured = false;
+    for (uint32_t i = 0; i < meshMaterials.size(); i++) {
+        const Material& material = meshMaterials[i];
+        const ImageData* diffuseMap = nullptr;
+        if (!material.diffuseTextureMap.empty())
+            diffuseMap = imageCache->requireImage(material.diffuseTextureMap);
+        materials.diffuseMaps.push_back(diffuseMap);
+        materials.diffuseColors.push_back(packVoxelColor(material.diffuseColor));
+        textured |= diffuseMap != nullptr;
+
+        uint32_t lastIndex = std::min<size_t>(firstIndex + material.indexCount, indices.size());
+        for (uint32_t j = firstIndex / 3; j < lastIndex / 3; j++)
+            materials.triangleMaterials[j] = i;
+        firstIndex = lastIndex;
+    }
+
+    if (textured) {
+        materials.uvs = std::vector<glm::vec2>(vertices.size());
+        for (size_t i = 0; i < vertices.size(); i++)
+            materials.uvs[i] = vertices[i].uv;
+    }
+    return materials;
+}
+
+VoxelMaterials Voxelizer::getDefaultMaterials(size_t triangleCount) {
+    VoxelMaterials materials;
+    materials.triangleMaterials = std::vector<uint32_t>(triangleCount, 0);
+    materials.diffuseMaps = { nullptr };
+    materials.diffuseColors = { packVoxelColor(VOXELIZER_DEFAULT_COLOR) };
+    return materials;
+}
+
+std::vector<glm::vec3> Voxelizer::getTriangleNormals(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices) {
+    // Degenerate triangles keep a zero normal, they never produce samples
+    std::vector<glm::vec3> triangleNormals(indices.size() / 3, glm::vec3(0.0f));
+    for (uint32_t i = 0; i < triangleNormals.size(); i++) {
+        glm::vec3 v0 = positions[indices[i * 3 + 0]];
+        glm::vec3 v1 = positions[indices[i * 3 + 1]];
+        glm::vec3 v2 = positions[indices[i * 3 + 2]];
+        glm::vec3 normal = glm::cross(v1 - v0, v2 - v0);
+        if (glm::length(normal) > 0.0f)
+            triangleNormals[i] = glm::normalize(normal);
+    }
+    return triangleNormals;
+}
+
+std::vector<Voxel> Voxelizer::mergeSamples(std::vector<std::vector<VoxelSample>>& batchSamples, const std::vector<glm::vec3>& triangleNormals, ThreadPool* pool) {
+    auto startTime = std::chrono::steady_clock::now();
+
+    size_t batchCount = batchSamples.size();
+    std::vector<glm::ivec3> batchMinCells(batchCount, glm::ivec3(INT32_MAX));
+    std::vector<glm::ivec3> batchMaxCells(batchCount, glm::ivec3(INT32_MIN));
+    for (size_t batch = 0; batch < batchCount; batch++)
+        pool->submit([&batchSamples, &batchMinCells, &batchMaxCells, batch]() {
+            for (const VoxelSample& sample : batchSamples[batch]) {
+                batchMinCells[batch] = glm::min(batchMinCells[batch], sample.cell);
+                batchMaxCells[batch] = glm::max(batchMaxCells[batch], sample.cell);
+            }
+        });
+    pool->wait();
+
+    glm::ivec3 minCell = glm::ivec3(INT32_MAX);
+    glm::ivec3 maxCell = glm::ivec3(INT32_MIN);
+    size_t sampleCount = 0;
+    for (size_t batch = 0; batch < batchCount; batch++) {
+        minCell = glm::min(minCell, batchMinCells[batch]);
+        maxCell = glm::max(maxCell, batchMaxCells[batch]);
+        sampleCount += batchSamples[batch].size();
+    }
+    if (sampleCount == 0) return std::vector<Voxel>();
+
+    // Cells are merged in slabs of rows along y, the most significant axis of both grid
+    // layouts. Slabs keep the layout of the whole grid, so their cells concatenate in its order
+    uint32_t slabCount = (maxCell.y - minCell.y) / VOXELIZER_MERGE_SLAB + 1;
+
+    // Every batch is reordered by slab in place, keeping the sample order inside each slab,
+    // so the cells still sum their samples in batch order
+    std::vector<size_t> slabOffsets(batchCount * (slabCount + 1), 0);
+    for (size_t batch = 0; batch < batchCount; batch++)
+        pool->submit([&batchSamples, &slabOffsets, slabCount, minCell, batch]() {
+            std::vector<VoxelSample>& samples = batchSamples[batch];
+            size_t* offsets = &slabOffsets[batch * (slabCount + 1)];
+            for (const VoxelSample& sample : samples)
+                offsets[(sample.cell.y - minCell.y) / VOXELIZER_MERGE_SLAB + 1]++;
+            for (uint32_t slab = 0; slab < slabCount; slab++)
+                offsets[slab + 1] += offsets[slab];
+
+            std::vector<size_t> nextSample(offsets, offsets + slabCount);
+            std::vector<VoxelSample> slabSamples(samples.size());
+            for (const VoxelSample& sample : samples)
+                slabSamples[nextSample[(sample.cell.y - minCell.y) / VOXELIZER_MERGE_SLAB]++] = sample;
+            samples.swap(slabSamples);
+        });
+    pool->wait();
+
+    bool dense = OccupancyGrid::fitsDense(minCell, maxCell);
+    std::vector<std::vector<Voxel>> slabVoxels(slabCount);
+    std::vector<size_t> slabPageCounts(slabCount, 0);
+    std::vector<size_t> slabGridBytes(slabCount, 0);
+    for (uint32_t slab = 0; slab < slabCount; slab++) {
+        pool->submit([&, slab]() {
+            glm::ivec3 slabMinCell = glm::ivec3(minCell.x, minCell.y + slab * VOXELIZER_MERGE_SLAB, minCell.z);
+            glm::ivec3 slabMaxCell = glm::ivec3(maxCell.x, std::min(slabMinCell.y + VOXELIZER_MERGE_SLAB - 1, maxCell.y), maxCell.z);
+            auto getSlabSamples = [&](size_t batch) {
+                const size_t* offsets = &slabOffsets[batch * (slabCount + 1)];
+                return std::span<const VoxelSample>(batchSamples[batch].data() + offsets[slab], offsets[slab + 1] - offsets[slab]);
+            };
 
-    uint32_t numPoints;
-    float a, b, c, p, area, lambda, mu;
-    glm::vec3 v0, v1, v2, v3, v4, v5, point, normal;
+            // Every sample marks its cell once, then cell indices address the attribute sums
+            OccupancyGrid grid(slabMinCell, slabMaxCell, dense);
+            for (size_t batch = 0; batch < batchCount; batch++)
+                for (const VoxelSample& sample : getSlabSamples(batch))
+                    grid.insert(sample.cell);
+            if (grid.getCellCount() == 0) return;
+            grid.buildCellIndices();
+
+            std::vector<glm::vec3> normalSums(grid.getCellCount(), glm::vec3(0.0f));
+            std::vector<glm::uvec3> colorSums(grid.getCellCount(), glm::uvec3(0));
+            std::vector<uint32_t> sampleCounts(grid.getCellCount(), 0);
+            for (size_t batch = 0; batch < batchCount; batch++) {
+                for (const VoxelSample& sample : getSlabSamples(batch)) {
+                    uint32_t cellIndex = grid.getCellIndex(sample.cell);
+                    normalSums[cellIndex] += triangleNormals[sample.triangle];
+                    colorSums[cellIndex] += glm::uvec3((sample.color >> 16) & 0xFF, (sample.color >> 8) & 0xFF, sample.color & 0xFF);
+                    sampleCounts[cellIndex]++;
+                }
+            }
+
+            std::vector<glm::ivec3> cells = grid.getCells();
+            std::vector<Voxel>& voxels = slabVoxels[slab];
+            voxels.resize(cells.size());
+            for (uint32_t i = 0; i < cells.size(); i++) {
+                voxels[i].position = glm::vec3(cells[i]) + glm::vec3(0.5f);
+                voxels[i].normal = glm::length(normalSums[i]) > 0.0f ? glm::normalize(normalSums[i]) : normalSums[i];
+                voxels[i].renderData = getAverageColor(colorSums[i], sampleCounts[i]);
+            }
+            slabPageCounts[slab] = grid.getPageCount();
+            slabGridBytes[slab] = grid.getMemoryUsage();
+        });
+    }
+    pool->wait();
+
+    size_t voxelCount = 0;
+    for (const std::vector<Voxel>& voxels : slabVoxels)
+        voxelCount += voxels.size();
     std::vector<Voxel> voxels;
-    for (uint32_t i = 0; i < indices.size(); i += 3) {
-        v0 = vertices[indices[i + 0]].position;
-        v1 = vertices[indices[i + 1]].position;
-        v2 = vertices[indices[i + 2]].position;
-        v3 = v0 - v1;
-        v4 = v1 - v2;
-        v5 = v0 - v2;
-        normal = glm::normalize(glm::cross(v1 - v0, v2 - v0));
-
-        a = glm::length(v3);
-        b = glm::length(v4);
-        c = glm::length(v5);
-        p = (a + b + c) / 2.0f;
-        area = std::sqrt(p * (p - a) * (p - b) * (p - c));
-        numPoints = std::round(density * area);
-        for (uint32_t j = 0; j < numPoints; j++) {
-            lambda = glm::linearRand(0.0f, 1.0f);
-            mu = glm::linearRand(0.0f, 1.0f);
-            point = (v0 + (lambda * v3)) + (v4 * (lambda * mu));
-            
-            Voxel v;
-            v.position = point;
-            v.normal = normal;
-
-            glm::vec3 color = glm::vec3(0.25f); // glm::linearRand(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f));
-            v.renderData = 0;
-            v.renderData += (uint8_t)(color.z * 255.0f);
-            v.renderData += (uint8_t)(color.y * 255.0f) << 8;
-            v.renderData += (uint8_t)(color.x * 255.0f) << 16;
-
-            voxels.push_back(v);
+    voxels.reserve(voxelCount);
+    size_t pageCount = 0;
+    size_t gridBytes = 0;
+    for (uint32_t slab = 0; slab < slabCount; slab++) {
+        voxels.insert(voxels.end(), slabVoxels[slab].begin(), slabVoxels[slab].end());
+        pageCount += slabPageCounts[slab];
+        gridBytes += slabGridBytes[slab];
+    }
+
+    double mergeTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    spdlog::info(std::to_string(sampleCount) + " voxel samples merged into " + std::to_string(voxels.size()) + " cells in " + std::to_string(mergeTime) + " ms over " + std::to_string(slabCount) + " slabs. " + (dense ? "Dense" : "Paged (" + std::to_string(pageCount) + " pages)") + " occupancy grids of " + std::to_string(gridBytes / 1024) + " KB.");
+    return voxels;
+}
+
+void Voxelizer::accumulateSamples(const std::vector<std::vector<VoxelSample>>& batchSamples, const std::vector<glm::vec3>& triangleNormals, std::unordered_map<glm::ivec3, VoxelCellSum>& cellSums) {
+    // Same summation order as mergeSamples, batch by batch
+    for (const std::vector<VoxelSample>& samples : batchSamples) {
+        for (const VoxelSample& sample : samples) {
+            VoxelCellSum& cellSum = cellSums[sample.cell];
+            cellSum.normal += triangleNormals[sample.triangle];
+            cellSum.color += glm::uvec3((sample.color >> 16) & 0xFF, (sample.color >> 8) & 0xFF, sample.color & 0xFF);
+            cellSum.sampleCount++;
         }
     }
+}
+
+std::vector<Voxel> Voxelizer::getAccumulatedVoxels(const std::unordered_map<glm::ivec3, VoxelCellSum>& cellSums) {
+    if (cellSums.empty()) return std::vector<Voxel>();
+
+    // The occupancy grid only orders the cells, like mergeSamples does
+    glm::ivec3 minCell = glm::ivec3(INT32_MAX);
+    glm::ivec3 maxCell = glm::ivec3(INT32_MIN);
+    for (const auto& [cell, cellSum] : cellSums) {
+        minCell = glm::min(minCell, cell);
+        maxCell = glm::max(maxCell, cell);
+    }
+
+    OccupancyGrid grid(minCell, maxCell);
+    for (const auto& [cell, cellSum] : cellSums)
+        grid.insert(cell);
+
+    std::vector<glm::ivec3> cells = grid.getCells();
+    std::vector<Voxel> voxels(cells.size());
+    for (uint32_t i = 0; i < cells.size(); i++) {
+        const VoxelCellSum& cellSum = cellSums.at(cells[i]);
+        voxels[i].position = glm::vec3(cells[i]) + glm::vec3(0.5f);
+        voxels[i].normal = glm::length(cellSum.normal) > 0.0f ? glm::normalize(cellSum.normal) : cellSum.normal;
+        voxels[i].renderData = getAverageColor(cellSum.color, cellSum.sampleCount);
+    }
     return voxels;
 }
 
-Mesh* Voxelizer::triangulateVolume(Volume volume) {
+uint32_t Voxelizer::getAverageColor(glm::uvec3 colorSum, uint32_t sampleCount) {
+    // Rounded to the nearest 8 bit value, packed like packVoxelColor
+    glm::uvec3 color = (colorSum + sampleCount / 2) / glm::max(sampleCount, 1u);
+    return (color.x << 16) | (color.y << 8) | color.z;
+}
+
+std::vector<VoxelSpan> Voxelizer::fillSolid(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const std::vector<Voxel>& shell, ThreadPool* pool) {
+    if (shell.empty()) return std::vector<VoxelSpan>();
+
+    VoxelRows shellRows = getShellRows(shell);
+    glm::ivec3 minCell = shellRows.minCell;
+    glm::ivec3 maxCell = shellRows.minCell + shellRows.size - 1;
+
+    std::vector<VoxelSpan> spans;
+    bool filled = false;
+    if (!indices.empty() && isMeshClosed(positions, indices)) {
+        // Bin triangles by the rows of cell centers they cross in y
+        std::vector<std::vector<uint32_t>> slabTriangles(shellRows.size.y);
+        for (uint32_t i = 0; i + 2 < indices.size(); i += 3) {
+            float minY = std::min(positions[indices[i]].y, std::min(positions[indices[i + 1]].y, positions[indices[i + 2]].y));
+            float maxY = std::max(positions[indices[i]].y, std::max(positions[indices[i + 1]].y, positions[indices[i + 2]].y));
+            int firstY = std::max((int)std::ceil(minY - 0.5f), minCell.y);
+            int lastY = std::min((int)std::floor(maxY - 0.5f), maxCell.y);
+            for (int y = firstY; y <= lastY; y++)
+                slabTriangles[y - minCell.y].push_back(i);
+        }
+
+        // One task per y slab, every scanline along x is filled between crossing pairs
+        std::vector<std::vector<VoxelSpan>> slabSpans(shellRows.size.y);
+        std::vector<uint8_t> slabsEven(shellRows.size.y, 0);
+        for (int slab = 0; slab < shellRows.size.y; slab++)
+            pool->submit([&positions, &indices, &slabTriangles, &shellRows, &slabSpans, &slabsEven, slab]() {
+                slabsEven[slab] = fillSlabParity(positions, indices, slabTriangles[slab], shellRows.minCell.y + slab, shellRows, slabSpans[slab]);
+            });
+        pool->wait();
+
+        filled = std::find(slabsEven.begin(), slabsEven.end(), 0) == slabsEven.end();
+        if (filled) {
+            for (const std::vector<VoxelSpan>& slab : slabSpans)
+                spans.insert(spans.end(), slab.begin(), slab.end());
+        }
+        else spdlog::warn("Scanline with an odd number of crossings, filling the volume from the outside instead.");
+    }
+    else if (!indices.empty()) spdlog::warn("Mesh is not closed, filling the volume from the outside.");
+
+    if (!filled)
+        spans = fillFromOutside(shellRows);
+
+    size_t cellCount = 0;
+    for (const VoxelSpan& span : spans)
+        cellCount += span.xEnd - span.xBegin;
+    size_t spanBytes = spans.size() * sizeof(VoxelSpan);
+    size_t voxelBytes = cellCount * sizeof(Voxel);
+    spdlog::info("Solid voxelization: " + std::to_string(cellCount) + " cells (" + std::to_string(cellCount - shell.size()) + " interior) in " + std::to_string(spans.size()) + " spans, " + std::to_string(spanBytes / 1024) + " KB instead of " + std::to_string(voxelBytes / 1024) + " KB of voxels.");
+    return spans;
+}
+
+VoxelRows Voxelizer::getShellRows(const std::vector<Voxel>& shell) {
+    VoxelRows rows;
+    glm::ivec3 minCell = glm::ivec3(INT32_MAX);
+    glm::ivec3 maxCell = glm::ivec3(INT32_MIN);
+    for (const Voxel& voxel : shell) {
+        minCell = glm::min(minCell, glm::ivec3(glm::floor(voxel.position)));
+        maxCell = glm::max(maxCell, glm::ivec3(glm::floor(voxel.position)));
+    }
+    rows.minCell = minCell;
+    rows.size = maxCell - minCell + 1;
+
+    // row << 32 | x, sorted, so runs of consecutive x come out in order
+    std::vector<uint64_t> keys(shell.size());
+    for (size_t i = 0; i < shell.size(); i++) {
+        glm::ivec3 cell = glm::ivec3(glm::floor(shell[i].position)) - minCell;
+        uint64_t row = (uint64_t)cell.y * rows.size.z + cell.z;
+        keys[i] = (row << 32) | (uint32_t)cell.x;
+    }
+    std::sort(keys.begin(), keys.end());
+
+    rows.rowOffsets = std::vector<uint32_t>((size_t)rows.size.y * rows.size.z + 1, 0);
+    for (uint64_t key : keys) {
+        uint32_t row = key >> 32;
+        int x = (int)(key & 0xFFFFFFFF) + minCell.x;
+        VoxelSpan span = {
+            .y = (int)(row / rows.size.z) + minCell.y,
+            .z = (int)(row % rows.size.z) + minCell.z,
+            .xBegin = x,
+            .xEnd = x + 1
+        };
+
+        size_t spanCount = rows.spans.size();
+        appendSpan(rows.spans, span);
+        if (rows.spans.size() > spanCount)
+            rows.rowOffsets[row + 1]++;
+    }
+    for (size_t i = 1; i < rows.rowOffsets.size(); i++)
+        rows.rowOffsets[i] += rows.rowOffsets[i - 1];
+
+    return rows;
+}
+
+VoxelRows Voxelizer::getSpanRows(const std::vector<VoxelSpan>& spans) {
+    VoxelRows rows;
+    glm::ivec3 minCell = glm::ivec3(INT32_MAX);
+    glm::ivec3 maxCell = glm::ivec3(INT32_MIN);
+    for (const VoxelSpan& span : spans) {
+        minCell = glm::min(minCell, glm::ivec3(span.xBegin, span.y, span.z));
+        maxCell = glm::max(maxCell, glm::ivec3(span.xEnd - 1, span.y, span.z));
+    }
+    rows.minCell = spans.empty() ? glm::ivec3(0) : minCell;
+    rows.size = spans.empty() ? glm::ivec3(0) : maxCell - minCell + 1;
+    rows.spans = spans;
+
+    // Spans are already sorted by y, z, x, only the rows are counted
+    rows.rowOffsets = std::vector<uint32_t>((size_t)rows.size.y * rows.size.z + 1, 0);
+    for (const VoxelSpan& span : spans)
+        rows.rowOffsets[(size_t)(span.y - rows.minCell.y) * rows.size.z + span.z - rows.minCell.z + 1]++;
+    for (size_t i = 1; i < rows.rowOffsets.size(); i++)
+        rows.rowOffsets[i] += rows.rowOffsets[i - 1];
+
+    return rows;
+}
+
+bool Voxelizer::isMeshClosed(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices) {
+    // Vertices are welded by position, split normals and UV seams do not open the mesh.
+    // Closed means every edge is shared by an even number of triangles
+    std::unordered_map<glm::vec3, uint32_t> weldedVertices;
+    std::vector<uint32_t> welded(positions.size());
+    for (uint32_t i = 0; i < positions.size(); i++)
+        welded[i] = weldedVertices.try_emplace(positions[i], (uint32_t)weldedVertices.size()).first->second;
+
+    std::unordered_map<uint64_t, uint32_t> edgeCounts;
+    for (uint32_t i = 0; i + 2 < indices.size(); i += 3) {
+        for (uint32_t j = 0; j < 3; j++) {
+            uint32_t a = welded[indices[i + j]];
+            uint32_t b = welded[indices[i + (j + 1) % 3]];
+            if (a == b) continue;
+            edgeCounts[((uint64_t)std::min(a, b) << 32) | std::max(a, b)]++;
+        }
+    }
+
+    for (const auto& [edge, count] : edgeCounts)
+        if (count % 2 != 0) return false;
+    return true;
+}
+
+bool Voxelizer::fillSlabParity(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const std::vector<uint32_t>& triangles, int y, const VoxelRows& shellRows, std::vector<VoxelSpan>& spans) {
+    int minZ = shellRows.minCell.z;
+    int maxZ = shellRows.minCell.z + shellRows.size.z - 1;
+    float centerY = y + 0.5f;
+
+    // x of every triangle crossing the scanline through the cell centers of each row
+    std::vector<std::vector<float>> crossings(shellRows.size.z);
+    for (uint32_t i : triangles) {
+        glm::vec3 v0 = positions[indices[i + 0]];
+        glm::vec3 v1 = positions[indices[i + 1]];
+        glm::vec3 v2 = positions[indices[i + 2]];
+        glm::vec3 normal = glm::cross(v1 - v0, v2 - v0);
+        if (normal.x == 0.0f) continue;
+
+        // Triangle projected on the zy plane, counter clockwise
+        glm::vec2 p[3] = {glm::vec2(v0.z, v0.y), glm::vec2(v1.z, v1.y), glm::vec2(v2.z, v2.y)};
+        if (normal.x > 0.0f) std::swap(p[1], p[2]);
+
+        float minTriangleZ = std::min(p[0].x, std::min(p[1].x, p[2].x));
+        float maxTriangleZ = std::max(p[0].x, std::max(p[1].x, p[2].x));
+        int firstZ = std::max((int)std::ceil(minTriangleZ - 0.5f), minZ);
+        int lastZ = std::min((int)std::floor(maxTriangleZ - 0.5f), maxZ);
+        for (int z = firstZ; z <= lastZ; z++) {
+            glm::vec2 point = glm::vec2(z + 0.5f, centerY);
+
+            // Points on an edge belong to one side only, so a scanline through
+            // a shared edge or vertex is crossed exactly once
+            bool inside = true;
+            for (uint32_t j = 0; j < 3 && inside; j++) {
+                glm::vec2 a = p[j];
+                glm::vec2 b = p[(j + 1) % 3];
+                glm::vec2 edge = b - a;
+                float side = edge.x * (point.y - a.y) - edge.y * (point.x - a.x);
+                bool ownsEdge = edge.y > 0.0f || (edge.y == 0.0f && edge.x < 0.0f);
+                inside = side > 0.0f || (side == 0.0f && ownsEdge);
+            }
+            if (!inside) continue;
+
+            float x = v0.x - (normal.y * (centerY - v0.y) + normal.z * (point.x - v0.z)) / normal.x;
+            crossings[z - minZ].push_back(x);
+        }
+    }
+
+    bool even = true;
+    for (int z = minZ; z <= maxZ; z++) {
+        std::vector<float>& rowCrossings = crossings[z - minZ];
+        if (rowCrossings.size() % 2 != 0) even = false;
+        std::sort(rowCrossings.begin(), rowCrossings.end());
+
+        // Cells whose center lies between a pair of crossings
+        std::vector<VoxelSpan> interior;
+        for (size_t i = 0; i + 1 < rowCrossings.size(); i += 2) {
+            VoxelSpan span = {
+                .y = y,
+                .z = z,
+                .xBegin = (int)std::floor(rowCrossings[i] - 0.5f) + 1,
+                .xEnd = (int)std::ceil(rowCrossings[i + 1] - 0.5f)
+            };
+            if (span.xBegin < span.xEnd) interior.push_back(span);
+        }
+
+        // Merged with the surface cells of the row in x order
+        uint32_t row = (uint32_t)(y - shellRows.minCell.y) * shellRows.size.z + (z - minZ);
+        uint32_t shellSpan = shellRows.rowOffsets[row];
+        uint32_t shellEnd = shellRows.rowOffsets[row + 1];
+        size_t interiorSpan = 0;
+        while (shellSpan < shellEnd || interiorSpan < interior.size()) {
+            if (interiorSpan == interior.size() || (shellSpan < shellEnd && shellRows.spans[shellSpan].xBegin < interior[interiorSpan].xBegin))
+                appendSpan(spans, shellRows.spans[shellSpan++]);
+            else
+                appendSpan(spans, interior[interiorSpan++]);
+        }
+    }
+
+    return even;
+}
+
+std::vector<VoxelSpan> Voxelizer::fillFromOutside(const VoxelRows& shellRows) {
+    // Flood fill over the gaps between surface spans rather than over cells. The
+    // grid grows by one cell on every side, so the outside is a single region
+    glm::ivec3 minCell = shellRows.minCell - 1;
+    glm::ivec3 size = shellRows.size + 2;
+
+    VoxelRows gapRows;
+    gapRows.minCell = minCell;
+    gapRows.size = size;
+    gapRows.rowOffsets = std::vector<uint32_t>((size_t)size.y * size.z + 1, 0);
+    for (int y = minCell.y; y < minCell.y + size.y; y++) {
+        for (int z = minCell.z; z < minCell.z + size.z; z++) {
+            uint32_t gapRow = (uint32_t)(y - minCell.y) * size.z + (z - minCell.z);
+            int x = minCell.x;
+
+            bool shellRow = y > minCell.y && y < minCell.y + size.y - 1 && z > minCell.z && z < minCell.z + size.z - 1;
+            if (shellRow) {
+                uint32_t row = (uint32_t)(y - shellRows.minCell.y) * shellRows.size.z + (z - shellRows.minCell.z);
+                for (uint32_t i = shellRows.rowOffsets[row]; i < shellRows.rowOffsets[row + 1]; i++) {
+                    const VoxelSpan& shellSpan = shellRows.spans[i];
+                    gapRows.spans.push_back({.y = y, .z = z, .xBegin = x, .xEnd = shellSpan.xBegin});
+                    x = shellSpan.xEnd;
+                }
+            }
+            gapRows.spans.push_back({.y = y, .z = z, .xBegin = x, .xEnd = minCell.x + size.x});
+            gapRows.rowOffsets[gapRow + 1] = gapRows.spans.size();
+        }
+    }
+
+    // Gaps in the first row are outside, everything reachable through overlapping
+    // gaps of the four neighbor rows is outside too
+    std::vector<uint8_t> outside(gapRows.spans.size(), 0);
+    std::vector<uint32_t> stack = {0};
+    outside[0] = 1;
+    glm::ivec2 neighborRows[4] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+    while (!stack.empty()) {
+        const VoxelSpan& gap = gapRows.spans[stack.back()];
+        stack.pop_back();
+
+        for (glm::ivec2 offset : neighborRows) {
+            int y = gap.y + offset.x;
+            int z = gap.z + offset.y;
+            if (y < minCell.y || y >= minCell.y + size.y || z < minCell.z || z >= minCell.z + size.z) continue;
+
+            uint32_t row = (uint32_t)(y - minCell.y) * size.z + (z - minCell.z);
+            for (uint32_t i = gapRows.rowOffsets[row]; i < gapRows.rowOffsets[row + 1]; i++) {
+                const VoxelSpan& neighbor = gapRows.spans[i];
+                if (neighbor.xBegin >= gap.xEnd) break;
+                if (neighbor.xEnd <= gap.xBegin || outside[i]) continue;
+                outside[i] = 1;
+                stack.push_back(i);
+            }
+        }
+    }
+
+    // Surface spans and the gaps the outside never reached
+    std::vector<VoxelSpan> spans;
+    for (int y = shellRows.minCell.y; y < shellRows.minCell.y + shellRows.size.y; y++) {
+        for (int z = shellRows.minCell.z; z < shellRows.minCell.z + shellRows.size.z; z++) {
+            uint32_t row = (uint32_t)(y - shellRows.minCell.y) * shellRows.size.z + (z - shellRows.minCell.z);
+            uint32_t gapRow = (uint32_t)(y - minCell.y) * size.z + (z - minCell.z);
+
+            // Gaps and surface spans alternate, starting and ending with a gap
+            uint32_t gap = gapRows.rowOffsets[gapRow];
+            for (uint32_t i = shellRows.rowOffsets[row]; i < shellRows.rowOffsets[row + 1]; i++, gap++) {
+                if (!outside[gap]) appendSpan(spans, gapRows.spans[gap]);
+                appendSpan(spans, shellRows.spans[i]);
+            }
+        }
+    }
+    return spans;
+}
+
+void Voxelizer::appendSpan(std::vector<VoxelSpan>& spans, VoxelSpan span) {
+    // Spans arrive sorted by xBegin within a row, touching ones are joined
+    if (span.xBegin >= span.xEnd) return;
+
+    if (!spans.empty()) {
+        VoxelSpan& last = spans.back();
+        if (last.y == span.y && last.z == span.z && span.xBegin <= last.xEnd) {
+            last.xEnd = std::max(last.xEnd, span.xEnd);
+            return;
+        }
+    }
+    spans.push_back(span);
+}
+
+std::shared_ptr<DistanceField> Voxelizer::getDistanceField(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const std::vector<Voxel>& shell, const std::vector<VoxelSpan>& solidSpans, ThreadPool* pool) {
+    if (shell.empty()) return nullptr;
+    auto startTime = std::chrono::steady_clock::now();
+
+    // The field covers the surface cells and the band around them
+    VoxelRows shellRows = getShellRows(shell);
+    std::shared_ptr<DistanceField> field = std::make_shared<DistanceField>(shellRows.minCell - VOXELIZER_DISTANCE_BAND, shellRows.size + 2 * VOXELIZER_DISTANCE_BAND);
+    glm::ivec3 minCell = field->getMinCell();
+    glm::ivec3 size = field->getSize();
+
+    // Bin triangles by the rows of cell centers within the band of them in y
+    std::vector<std::vector<uint32_t>> slabTriangles(size.y);
+    for (uint32_t i = 0; i + 2 < indices.size(); i += 3) {
+        float minY = std::min(positions[indices[i]].y, std::min(positions[indices[i + 1]].y, positions[indices[i + 2]].y));
+        float maxY = std::max(positions[indices[i]].y, std::max(positions[indices[i + 1]].y, positions[indices[i + 2]].y));
+        int firstY = std::max((int)std::ceil(minY - VOXELIZER_DISTANCE_BAND - 0.5f), minCell.y);
+        int lastY = std::min((int)std::floor(maxY + VOXELIZER_DISTANCE_BAND - 0.5f), minCell.y + size.y - 1);
+        for (int y = firstY; y <= lastY; y++)
+            slabTriangles[y - minCell.y].push_back(i);
+    }
+
+    // Triangles face out when the signed volume they enclose is positive, inward wound meshes flip the band signs
+    double signedVolume = 0.0;
+    for (uint32_t i = 0; i + 2 < indices.size(); i += 3)
+        signedVolume += glm::dot(positions[indices[i]], glm::cross(positions[indices[i + 1]], positions[indices[i + 2]]));
+    float orientation = signedVolume < 0.0 ? -1.0f : 1.0f;
+
+    // Exact distances in the band, one task per y slab, so no cell is written twice at once
+    for (int slab = 0; slab < size.y; slab++)
+        pool->submit([&positions, &indices, &slabTriangles, &field, minCell, orientation, slab]() {
+            fillDistanceBand(positions, indices, slabTriangles[slab], minCell.y + slab, orientation, field.get());
+        });
+    pool->wait();
+    slabTriangles.clear();
+    double bandTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+    field->sweep(VOXELIZER_DISTANCE_BAND, pool);
+    double sweepTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count() - bandTime;
+
+    // Solid spans grouped by row like the shell, both are sorted by y, z, x
+    VoxelRows solidRows = {
+        .minCell = shellRows.minCell,
+        .size = shellRows.size,
+        .rowOffsets = std::vector<uint32_t>(shellRows.rowOffsets.size(), 0),
+        .spans = solidSpans
+    };
+    for (const VoxelSpan& span : solidSpans)
+        solidRows.rowOffsets[(size_t)(span.y - solidRows.minCell.y) * solidRows.size.z + span.z - solidRows.minCell.z + 1]++;
+    for (size_t row = 1; row < solidRows.rowOffsets.size(); row++)
+        solidRows.rowOffsets[row] += solidRows.rowOffsets[row - 1];
+
+    for (int slab = 0; slab < size.y; slab++)
+        pool->submit([&shellRows, &solidRows, &field, minCell, slab]() {
+            signDistanceSlab(minCell.y + slab, shellRows, solidRows, field.get());
+        });
+    pool->wait();
+    double totalTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+    spdlog::info("Signed distance field of " + std::to_string(size.x) + "x" + std::to_string(size.y) + "x" + std::to_string(size.z) + " cells in " + std::to_string(field->getBrickCount()) + " bricks (" + std::to_string(field->getMemoryUsage() / (1024 * 1024)) + " MB) in " + std::to_string(totalTime) + " ms. Band " + std::to_string(bandTime) + " ms, sweeps " + std::to_string(sweepTime) + " ms, signs " + std::to_string(totalTime - bandTime - sweepTime) + " ms (" + std::to_string(field->getCellCount() / totalTime / 1e3) + " Mcells/s).");
+    return field;
+}
+
+void Voxelizer::fillDistanceBand(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const std::vector<uint32_t>& triangles, int y, float orientation, DistanceField* field) {
+    glm::ivec3 minCell = field->getMinCell();
+    glm::ivec3 maxCell = minCell + field->getSize() - 1;
+    int rowSize = maxCell.x - minCell.x + 1;
+    size_t slabCells = (size_t)rowSize * (maxCell.z - minCell.z + 1);
+
+    // Closest distance of every cell of the slab, the sign of the triangle it faces
+    // most directly among the tied ones, so cells off an edge or a vertex get the
+    // sign of the right side
+    std::vector<float> magnitudes(slabCells, std::numeric_limits<float>::max());
+    std::vector<float> alignments(slabCells, 0.0f);
+    std::vector<int8_t> signs(slabCells, 1);
+
+    for (uint32_t i : triangles) {
+        glm::vec3 v0 = positions[indices[i + 0]];
+        glm::vec3 v1 = positions[indices[i + 1]];
+        glm::vec3 v2 = positions[indices[i + 2]];
+        glm::vec3 normal = glm::cross(v1 - v0, v2 - v0);
+        if (glm::length(normal) == 0.0f) continue;
+        normal = glm::normalize(normal) * orientation;
+
+        // The band around the triangle's bounds, narrowed by how far the slab is from them in y
+        glm::vec3 lowCorner = glm::min(v0, glm::min(v1, v2));
+        glm::vec3 highCorner = glm::max(v0, glm::max(v1, v2));
+        float slabDistance = std::max(0.0f, std::max(lowCorner.y - (y + 0.5f), (y + 0.5f) - highCorner.y));
+        float radius = std::sqrt(std::max((float)(VOXELIZER_DISTANCE_BAND * VOXELIZER_DISTANCE_BAND) - slabDistance * slabDistance, 0.0f));
+        lowCorner -= radius + 0.5f;
+        highCorner += radius - 0.5f;
+        int firstX = std::max((int)std::ceil(lowCorner.x), minCell.x);
+        int lastX = std::min((int)std::floor(highCorner.x), maxCell.x);
+        int firstZ = std::max((int)std::ceil(lowCorner.z), minCell.z);
+        int lastZ = std::min((int)std::floor(highCorner.z), maxCell.z);
+        for (int z = firstZ; z <= lastZ; z++) {
+            for (int x = firstX; x <= lastX; x++) {
+                glm::vec3 center = glm::vec3(x, y, z) + 0.5f;
+                glm::vec3 offset = center - getClosestTrianglePoint(center, v0, v1, v2);
+                float distance = glm::length(offset);
+                if (distance > VOXELIZER_DISTANCE_BAND) continue;
+
+                size_t cell = (size_t)(z - minCell.z) * rowSize + x - minCell.x;
+                float planeDistance = glm::dot(offset, normal);
+                float alignment = distance > 0.0f ? std::abs(planeDistance) / distance : 1.0f;
+                if (distance < magnitudes[cell] - VOXELIZER_DISTANCE_TIE || (distance <= magnitudes[cell] + VOXELIZER_DISTANCE_TIE && alignment > alignments[cell])) {
+                    alignments[cell] = alignment;
+                    signs[cell] = planeDistance < 0.0f ? -1 : 1;
+                }
+                magnitudes[cell] = std::min(magnitudes[cell], distance);
+            }
+        }
+    }
+
+    for (int z = minCell.z; z <= maxCell.z; z++) {
+        for (int x = minCell.x; x <= maxCell.x; x++) {
+            size_t cell = (size_t)(z - minCell.z) * rowSize + x - minCell.x;
+            if (magnitudes[cell] != std::numeric_limits<float>::max())
+                field->setDistance(glm::ivec3(x, y, z), signs[cell] * magnitudes[cell]);
+        }
+    }
+}
+
+void Voxelizer::signDistanceSlab(int y, const VoxelRows& shellRows, const VoxelRows& solidRows, DistanceField* field) {
+    // Cells inside the solid are negative. Surface cells keep the sign their closest
+    // triangle gave them, the solid counts them as inside whichever side their center is on
+    glm::ivec3 minCell = field->getMinCell();
+    glm::ivec3 size = field->getSize();
+    std::vector<int8_t> rowSigns(size.x);
+    for (int z = minCell.z; z < minCell.z + size.z; z++) {
+        std::fill(rowSigns.begin(), rowSigns.end(), 1);
+
+        glm::ivec3 rowCell = glm::ivec3(0, y, z) - shellRows.minCell;
+        if (rowCell.y >= 0 && rowCell.y < shellRows.size.y && rowCell.z >= 0 && rowCell.z < shellRows.size.z) {
+            size_t row = (size_t)rowCell.y * shellRows.size.z + rowCell.z;
+            for (uint32_t i = solidRows.rowOffsets[row]; i < solidRows.rowOffsets[row + 1]; i++)
+                for (int x = solidRows.spans[i].xBegin; x < solidRows.spans[i].xEnd; x++)
+                    rowSigns[x - minCell.x] = -1;
+            for (uint32_t i = shellRows.rowOffsets[row]; i < shellRows.rowOffsets[row + 1]; i++)
+                for (int x = shellRows.spans[i].xBegin; x < shellRows.spans[i].xEnd; x++)
+                    rowSigns[x - minCell.x] = 0;
+        }
+
+        for (int x = 0; x < size.x; x++) {
+            if (rowSigns[x] == 0) continue;
+            glm::ivec3 cell = glm::ivec3(minCell.x + x, y, z);
+            field->setDistance(cell, rowSigns[x] * std::abs(field->getDistance(cell)));
+        }
+    }
+}
+
+Mesh* Voxelizer::triangulateVolume(const Volume& volume) {
+    auto startTime = std::chrono::steady_clock::now();
+    Mesh* volumeMesh;
+    std::string meshingName;
+    if (meshing == VOLUME_MESHING_CULLED || meshing == VOLUME_MESHING_GREEDY) {
+        ThreadPool pool(std::max(threadCount, 1));
+        volumeMesh = getFaceMesh(volume, meshing == VOLUME_MESHING_GREEDY, &pool);
+        meshingName = meshing == VOLUME_MESHING_GREEDY ? "greedy" : "culled faces";
+    }
+    else {
+        volumeMesh = getCubeMesh(volume);
+        meshingName = "cubes";
+    }
+
+    double meshingTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    spdlog::info(std::to_string(volume.voxels.size()) + " voxels triangulated (" + meshingName + ") into " + std::to_string(volumeMesh->getNumVertices()) + " vertices and " + std::to_string(volumeMesh->getNumIndices() / 3) + " triangles in " + std::to_string(meshingTime) + " ms.");
+    return volumeMesh;
+}
+
+Mesh* Voxelizer::getCubeMesh(const Volume& volume) {
     std::vector<Vertex> vertices;
     std::vector<uint32_t> indices;
 
     uint32_t index = 0;
     float voxelSize = 0.3f;
     for (uint32_t i = 0; i < volume.voxels.size(); i++, index += 8) {
-        uint32_t voxelColor = volume.voxels[i].renderData;
-        glm::vec3 color = glm::vec3((voxelColor & 0x00110000) >> 16, (voxelColor & 0x00001100) >> 8, voxelColor & 0x0000011);
+        glm::vec3 color = unpackVoxelColor(volume.voxels[i].renderData);
         Vertex v1 = {
             .position = glm::vec3(-voxelSize, -voxelSize, voxelSize) + volume.voxels[i].position,
             .normal = volume.voxels[i].normal,
@@ -161,11 +1149,159 @@ Mesh* Voxelizer::triangulateVolume(Volume volume) {
     return volumeMesh;
 }
 
-void Voxelizer::removeDuplicatedVoxels(std::vector<Voxel>& voxels) {
-    std::cout << "N° of voxels before duplicate removal: " << voxels.size() << std::endl;
-    std::sort(voxels.begin(), voxels.end(), [](Voxel& a, Voxel& b) -> bool {
-        return a < b;
-    });
-    voxels.erase(std::unique(voxels.begin(), voxels.end()), voxels.end());
-    std::cout << "N° of voxels after duplicate removal: " << voxels.size() << std::endl;
+Mesh* Voxelizer::getFaceMesh(const Volume& volume, bool greedy, ThreadPool* pool) {
+    // Voxels sorted by chunk, then by cell inside the chunk, so every chunk is one run
+    std::vector<MortonVoxel> cellKeys(volume.voxels.size());
+    for (uint32_t i = 0; i < volume.voxels.size(); i++)
+        cellKeys[i] = {getMeshCellKey(glm::ivec3(glm::floor(volume.voxels[i].position))), i};
+    Morton::radixSort(cellKeys, 64);
+
+    std::vector<std::pair<size_t, size_t>> chunkRanges;
+    for (size_t first = 0; first < cellKeys.size();) {
+        size_t last = first + 1;
+        while (last < cellKeys.size() && (cellKeys[last].code >> (3 * VOXELIZER_MESH_CHUNK_BITS)) == (cellKeys[first].code >> (3 * VOXELIZER_MESH_CHUNK_BITS)))
+            last++;
+        chunkRanges.push_back({first, last});
+        first = last;
+    }
+
+    // Chunks are meshed apart and joined in chunk order, so the mesh does not depend on the thread count
+    std::vector<std::vector<Vertex>> chunkVertices(chunkRanges.size());
+    std::vector<std::vector<uint32_t>> chunkIndices(chunkRanges.size());
+    for (size_t chunk = 0; chunk < chunkRanges.size(); chunk++)
+        pool->submit([&volume, &cellKeys, &chunkRanges, &chunkVertices, &chunkIndices, chunk, greedy]() {
+            meshChunk(volume.voxels, cellKeys, chunkRanges[chunk].first, chunkRanges[chunk].second, greedy, chunkVertices[chunk], chunkIndices[chunk]);
+        });
+    pool->wait();
+
+    size_t vertexCount = 0, indexCount = 0;
+    for (size_t chunk = 0; chunk < chunkRanges.size(); chunk++) {
+        vertexCount += chunkVertices[chunk].size();
+        indexCount += chunkIndices[chunk].size();
+    }
+
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    vertices.reserve(vertexCount);
+    indices.reserve(indexCount);
+    for (size_t chunk = 0; chunk < chunkRanges.size(); chunk++) {
+        uint32_t firstVertex = vertices.size();
+        vertices.insert(vertices.end(), chunkVertices[chunk].begin(), chunkVertices[chunk].end());
+        for (uint32_t index : chunkIndices[chunk])
+            indices.push_back(firstVertex + index);
+        chunkVertices[chunk] = std::vector<Vertex>();
+        chunkIndices[chunk] = std::vector<uint32_t>();
+    }
+
+    Mesh* volumeMesh = new Mesh();
+    volumeMesh->setVertices(vertices);
+    volumeMesh->setIndices(indices);
+    return volumeMesh;
+}
+
+void Voxelizer::meshChunk(const std::vector<Voxel>& voxels, const std::vector<MortonVoxel>& cellKeys, size_t begin, size_t end, bool greedy, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+    const int chunkSize = VOXELIZER_MESH_CHUNK;
+    const uint64_t localMask = (1ull << (3 * VOXELIZER_MESH_CHUNK_BITS)) - 1;
+
+    // Voxel index + 1 of every cell of the chunk, 0 for empty cells
+    std::vector<uint32_t> chunkVoxels(chunkSize * chunkSize * chunkSize, 0);
+    for (size_t i = begin; i < end; i++)
+        chunkVoxels[cellKeys[i].code & localMask] = cellKeys[i].index + 1;
+
+    uint64_t chunkKey = cellKeys[begin].code >> (3 * VOXELIZER_MESH_CHUNK_BITS);
+    glm::ivec3 origin = glm::ivec3(chunkKey & 0xFFFF, chunkKey >> 32, (chunkKey >> 16) & 0xFFFF) * chunkSize - glm::ivec3(VOXELIZER_MESH_CELL_BIAS);
+    auto getLocalOffset = [](glm::ivec3 local) -> uint32_t {
+        return (local.y << (2 * VOXELIZER_MESH_CHUNK_BITS)) | (local.z << VOXELIZER_MESH_CHUNK_BITS) | local.x;
+    };
+
+    // Neighbors outside the chunk are looked up in the sorted keys of the whole volume
+    auto isOccupied = [&](glm::ivec3 local) -> bool {
+        if (local.x >= 0 && local.y >= 0 && local.z >= 0 && local.x < chunkSize && local.y < chunkSize && local.z < chunkSize)
+            return chunkVoxels[getLocalOffset(local)] != 0;
+
+        uint64_t key = getMeshCellKey(origin + local);
+        auto match = std::lower_bound(cellKeys.begin(), cellKeys.end(), key, [](const MortonVoxel& cellKey, uint64_t key) -> bool {
+            return cellKey.code < key;
+        });
+        return match != cellKeys.end() && match->code == key;
+    };
+
+    // Visible faces of one slice, as voxel color + 1 so 0 means no face
+    std::vector<uint64_t> faceMask(chunkSize * chunkSize);
+    for (int axis = 0; axis < 3; axis++) {
+        // (u, v, axis) is right handed, so quads wound u then v face the positive axis
+        int uAxis = (axis + 1) % 3;
+        int vAxis = (axis + 2) % 3;
+        for (int direction = -1; direction <= 1; direction += 2) {
+            glm::ivec3 step = glm::ivec3(0);
+            step[axis] = direction;
+            glm::vec3 normal = glm::vec3(step);
+
+            for (int slice = 0; slice < chunkSize; slice++) {
+                bool anyFace = false;
+                for (int v = 0; v < chunkSize; v++)
+                    for (int u = 0; u < chunkSize; u++) {
+                        glm::ivec3 local;
+                        local[axis] = slice;
+                        local[uAxis] = u;
+                        local[vAxis] = v;
+                        uint32_t voxel = chunkVoxels[getLocalOffset(local)];
+                        bool visible = voxel != 0 && !isOccupied(local + step);
+                        faceMask[v * chunkSize + u] = visible ? (uint64_t)voxels[voxel - 1].renderData + 1 : 0;
+                        anyFace |= visible;
+                    }
+                if (!anyFace) continue;
+
+                // Grow every face along u, then along v while whole rows match
+                float plane = (float)(slice + (direction > 0 ? 1 : 0));
+                for (int v = 0; v < chunkSize; v++)
+                    for (int u = 0; u < chunkSize; u++) {
+                        uint64_t face = faceMask[v * chunkSize + u];
+                        if (face == 0) continue;
+
+                        int width = 1, height = 1;
+                        if (greedy) {
+                            while (u + width < chunkSize && faceMask[v * chunkSize + u + width] == face)
+                                width++;
+                            for (bool rowMatches = true; rowMatches && v + height < chunkSize; ) {
+                                for (int k = 0; k < width && rowMatches; k++)
+                                    rowMatches = faceMask[(v + height) * chunkSize + u + k] == face;
+                                if (rowMatches) height++;
+                            }
+                        }
+                        for (int j = 0; j < height; j++)
+                            std::fill_n(faceMask.begin() + (v + j) * chunkSize + u, width, 0);
+
+                        glm::vec3 color = unpackVoxelColor((uint32_t)(face - 1));
+                        auto getCorner = [&](int cornerU, int cornerV) -> Vertex {
+                            glm::vec3 position;
+                            position[axis] = plane;
+                            position[uAxis] = (float)cornerU;
+                            position[vAxis] = (float)cornerV;
+                            return {
+                                .position = glm::vec3(origin) + position,
+                                .normal = normal,
+                                .color = color
+                            };
+                        };
+
+                        uint32_t index = vertices.size();
+                        vertices.insert(vertices.end(), {getCorner(u, v), getCorner(u + width, v), getCorner(u + width, v + height), getCorner(u, v + height)});
+                        if (direction > 0)
+                            indices.insert(indices.end(), {index, index + 1, index + 2, index + 2, index + 3, index});
+                        else
+                            indices.insert(indices.end(), {index, index + 3, index + 2, index + 2, index + 1, index});
+                    }
+            }
+        }
+    }
+}
+
+uint64_t Voxelizer::getMeshCellKey(glm::ivec3 cell) {
+    // | chunk y | chunk z | chunk x | cell y | cell z | cell x |, coordinates biased to be positive
+    glm::uvec3 biased = glm::uvec3(cell + glm::ivec3(VOXELIZER_MESH_CELL_BIAS));
+    uint32_t mask = VOXELIZER_MESH_CHUNK - 1;
+    uint64_t chunkKey = ((uint64_t)(biased.y >> VOXELIZER_MESH_CHUNK_BITS) << 32) | ((uint64_t)(biased.z >> VOXELIZER_MESH_CHUNK_BITS) << 16) | (biased.x >> VOXELIZER_MESH_CHUNK_BITS);
+    uint64_t localKey = ((biased.y & mask) << (2 * VOXELIZER_MESH_CHUNK_BITS)) | ((biased.z & mask) << VOXELIZER_MESH_CHUNK_BITS) | (biased.x & mask);
+    return (chunkKey << (3 * VOXELIZER_MESH_CHUNK_BITS)) | localKey;
 }
@@ -8,31 +8,178 @@
 #include <glm/gtx/hash.hpp>
 #include <vector>
 #include <unordered_set>
+#include <unordered_map>
 #include <cmath>
 #include <algorithm>
 #include <iostream>
+#include <random>
+#include <chrono>
+#include <memory>
+#include <span>
+#include <spdlog/spdlog.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 #include "Mesh.hpp"
 #include "Geometry.hpp"
+#include "ThreadPool.hpp"
+#include "OccupancyGrid.hpp"
+#include "OBJStream.hpp"
+#include "ImageCache.hpp"
+#include "DistanceField.hpp"
+#include "VoxelPyramid.hpp"
+
+// Bumped whenever the voxels of a mesh change for the same parameters, so cached volumes are dropped
+#define VOXELIZER_VERSION 1
+// Triangles per voxelization task. Batches are fixed, so the output does not depend on the thread count
+#define VOXELIZER_TRIANGLE_BATCH 4096
+// Rows along y merged by one task, whole occupancy pages so slabs keep the order of a single grid
+#define VOXELIZER_MERGE_SLAB OCCUPANCY_PAGE_SIZE
+// Surface samples generated and colored together, one AVX2 register of floats
+#define VOXELIZER_SAMPLE_LANES 8
+// Triangles read per chunk when streaming an OBJ file, a whole number of batches
+#define VOXELIZER_STREAM_CHUNK (256 * VOXELIZER_TRIANGLE_BATCH)
+static_assert(VOXELIZER_STREAM_CHUNK % VOXELIZER_TRIANGLE_BATCH == 0, "Streamed chunks must hold whole triangle batches");
+// Cells this close to a triangle get exact distances, the rest of the field is swept from them
+#define VOXELIZER_DISTANCE_BAND 2
+// Distances closer than this are ties, settled by the triangle the cell faces most directly
+#define VOXELIZER_DISTANCE_TIE 1e-4f
+// Cells per axis of a meshing chunk, each chunk is meshed by one task
+#define VOXELIZER_MESH_CHUNK_BITS 5
+#define VOXELIZER_MESH_CHUNK (1 << VOXELIZER_MESH_CHUNK_BITS)
+// Added to cell coordinates for the meshing keys, 16 bits of chunk per axis
+#define VOXELIZER_MESH_CELL_BIAS (1 << 20)
+// Color of meshes without materials
+#define VOXELIZER_DEFAULT_COLOR glm::vec3(0.25f)
+
+enum VoxelizationMode {
+    // density * area random points per triangle
+    VOXELIZATION_SAMPLING = 0,
+    // Every unit grid cell a triangle overlaps, once
+    VOXELIZATION_CONSERVATIVE = 1,
+    // Conservative surface plus every cell inside the mesh, as spans
+    VOXELIZATION_SOLID = 2,
+    // Solid plus a signed distance field around it
+    VOXELIZATION_SIGNED_DISTANCE = 3
+};
+
+enum VolumeMeshing {
+    // 8 vertices and 12 triangles per voxel
+    VOLUME_MESHING_CUBES = 0,
+    // One quad per voxel face without an occupied neighbor
+    VOLUME_MESHING_CULLED = 1,
+    // Visible faces of the same color merged into maximal rectangles
+    VOLUME_MESHING_GREEDY = 2
+};
+
+// A surface point or overlapped cell, merged with the others of its cell into
+// one voxel. Normals come from the triangle the sample was taken on
+struct VoxelSample {
+    glm::ivec3 cell;
+    uint32_t triangle;
+    // | R | G | B | like Voxel::renderData, averaged over the cell
+    uint32_t color;
+};
+
+// Running sums of a cell's samples while streaming
+struct VoxelCellSum {
+    glm::vec3 normal;
+    glm::uvec3 color;
+    uint32_t sampleCount;
+};
+
+// Where every triangle takes its color from. Triangles of a material with a
+// diffuse map look it up at the sample's UV, the others use the diffuse color
+struct VoxelMaterials {
+    std::vector<glm::vec2> uvs;
+    std::vector<uint32_t> triangleMaterials;
+    std::vector<const ImageData*> diffuseMaps;
+    std::vector<uint32_t> diffuseColors;
+};
+
+// Cells [xBegin, xEnd) of the grid row (y, z)
+struct VoxelSpan {
+    int y;
+    int z;
+    int xBegin;
+    int xEnd;
+};
+
+// Spans grouped by grid row. Row (y, z) is (y - minCell.y) * size.z + z - minCell.z
+struct VoxelRows {
+    glm::ivec3 minCell;
+    glm::ivec3 size;
+    std::vector<uint32_t> rowOffsets;
+    std::vector<VoxelSpan> spans;
+};
+
+// xoshiro128+ with one state per lane. Lanes advance together in plain loops
+// the compiler turns into SIMD, and give floats in [0, 1)
+struct SampleRandom {
+    uint32_t state[4][VOXELIZER_SAMPLE_LANES];
+
+    SampleRandom(uint64_t seed);
+    void next(float* values);
+};
 
 struct Volume {
     int scale;
     std::vector<Voxel> voxels;
+    // Surface and interior cells of a solid voxelization, sorted by y, z, x
+    std::vector<VoxelSpan> solidSpans;
+    // Signed distance voxelization only, padded by the band around the surface
+    std::shared_ptr<DistanceField> distanceField;
+    // Every level of detail of the voxels, in the octree frame
+    std::shared_ptr<VoxelPyramid> pyramid;
 };
 
 class Voxelizer {
 public:
     static int scale;
     static int density;
+    static int mode;
+    static int threadCount;
+    static int seed;
+    static int meshing;
 
-    static Volume voxelizeMesh(Mesh* mesh);
-    static Mesh* triangulateVolume(Volume volume);
+    static Volume voxelizeMesh(Mesh* mesh, ImageCache* imageCache = nullptr);
+    static Volume voxelizeOBJFile(std::string OBJPath);
+    static Mesh* triangulateVolume(const Volume& volume);
+    static void buildPyramid(Volume& volume, ThreadPool* pool = nullptr);
+    static VoxelRows getShellRows(const std::vector<Voxel>& shell);
+    static VoxelRows getSpanRows(const std::vector<VoxelSpan>& spans);
 private:
     Voxelizer();
 
-    static std::vector<Voxel> getMeshSurfacePoints(Mesh* mesh);
+    static std::vector<std::vector<VoxelSample>> getMeshSurfacePoints(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const VoxelMaterials& materials, uint32_t firstBatch, ThreadPool* pool);
+    static std::vector<std::vector<VoxelSample>> getMeshOverlappedCells(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const VoxelMaterials& materials, ThreadPool* pool);
+    static void sampleTriangleBatch(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const VoxelMaterials& materials, uint32_t batchIndex, uint32_t firstBatch, std::vector<VoxelSample>& samples);
+    static void overlapTriangleBatch(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const VoxelMaterials& materials, uint32_t batchIndex, std::vector<VoxelSample>& samples);
+    static void colorSamples(const VoxelMaterials& materials, uint32_t material, const float* us, const float* vs, VoxelSample* samples, uint32_t sampleCount);
+    static void lookupTexels(const ImageData* image, const float* us, const float* vs, uint32_t* colors);
+    static VoxelMaterials getMeshMaterials(Mesh* mesh, const std::vector<Vertex>& vertices, ImageCache* imageCache);
+    static VoxelMaterials getDefaultMaterials(size_t triangleCount);
+    static std::vector<glm::vec3> getTriangleNormals(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices);
+    static std::vector<Voxel> mergeSamples(std::vector<std::vector<VoxelSample>>& batchSamples, const std::vector<glm::vec3>& triangleNormals, ThreadPool* pool);
+    static void accumulateSamples(const std::vector<std::vector<VoxelSample>>& batchSamples, const std::vector<glm::vec3>& triangleNormals, std::unordered_map<glm::ivec3, VoxelCellSum>& cellSums);
+    static std::vector<Voxel> getAccumulatedVoxels(const std::unordered_map<glm::ivec3, VoxelCellSum>& cellSums);
+    static uint32_t getAverageColor(glm::uvec3 colorSum, uint32_t sampleCount);
+    static std::vector<VoxelSpan> fillSolid(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const std::vector<Voxel>& shell, ThreadPool* pool);
+    static bool isMeshClosed(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices);
+    static bool fillSlabParity(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const std::vector<uint32_t>& triangles, int y, const VoxelRows& shellRows, std::vector<VoxelSpan>& spans);
+    static std::vector<VoxelSpan> fillFromOutside(const VoxelRows& shellRows);
+    static void appendSpan(std::vector<VoxelSpan>& spans, VoxelSpan span);
+    static std::shared_ptr<DistanceField> getDistanceField(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const std::vector<Voxel>& shell, const std::vector<VoxelSpan>& solidSpans, ThreadPool* pool);
+    static void fillDistanceBand(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const std::vector<uint32_t>& triangles, int y, float orientation, DistanceField* field);
+    static void signDistanceSlab(int y, const VoxelRows& shellRows, const VoxelRows& solidRows, DistanceField* field);
+    static Mesh* getCubeMesh(const Volume& volume);
+    static Mesh* getFaceMesh(const Volume& volume, bool greedy, ThreadPool* pool);
+    static void meshChunk(const std::vector<Voxel>& voxels, const std::vector<MortonVoxel>& cellKeys, size_t begin, size_t end, bool greedy, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+    static uint64_t getMeshCellKey(glm::ivec3 cell);
     static void normalizeMesh(Mesh* mesh);
-    static void removeDuplicatedVoxels(std::vector<Voxel>& voxels);
+    static glm::mat4 getNormalizationMatrix(AABB meshBounds);
 };
 
 #endif
@@ -8,8 +8,8 @@ layout (location = 3) in vec2 fragTexCoord;
 layout (location = 0) out vec4 outColor;
 
 layout (std430, push_constant) uniform PushConstants {
-    layout (offset = 80) vec4 viewPosition;
-    layout (offset = 96) vec4 viewDirection;
+    layout (offset = 96) vec4 viewPosition;
+    layout (offset = 112) vec4 viewDirection;
 } pushConstants;
 
 void main() {
@@ -1,22 +1,28 @@
 #version 450
 
-layout (location = 0) in vec4 inPosition;
-layout (location = 1) in vec3 inNormal;
-layout (location = 2) in vec3 inColor;
-layout (location = 3) in vec2 inUV;
+layout (location = 0) in uvec4 inCell;
+layout (location = 1) in vec4 inColor;
 
-layout (location = 0) out vec4 pPosition;
+layout (location = 0) out vec3 pCell;
 layout (location = 1) out vec3 pNormal;
 layout (location = 2) out vec3 pColor;
-layout (location = 3) out vec2 pUV;
+
+// Octahedral normal, the lower half folded over the diagonals
+vec3 unpackOctahedralNormal(vec2 octahedral) {
+    vec3 normal = vec3(octahedral, 1.0f - abs(octahedral.x) - abs(octahedral.y));
+    float fold = max(-normal.z, 0.0f);
+    normal.x += normal.x >= 0.0f ? -fold : fold;
+    normal.y += normal.y >= 0.0f ? -fold : fold;
+    return normalize(normal);
+}
 
 void main() {
-    gl_Position = inPosition;
+    gl_Position = vec4(inCell.xyz, 1.0f);
 
     gl_PointSize = 1.0f;
 
-    pPosition = inPosition;
-    pColor = inColor;
-    pUV = inUV;
-    pNormal = inNormal;
+    // The normal is packed into w as two snorm8 components
+    pCell = vec3(inCell.xyz);
+    pNormal = unpackOctahedralNormal(unpackSnorm4x8(inCell.w).xy);
+    pColor = inColor.rgb;
 }
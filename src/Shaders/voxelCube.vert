@@ -0,0 +1,53 @@
+#version 450
+
+layout (location = 0) in uvec4 inCell;
+layout (location = 1) in vec4 inColor;
+
+layout (location = 0) out vec4 fragPosition;
+layout (location = 1) out vec3 fragNormal;
+layout (location = 2) out vec3 fragColor;
+layout (location = 3) out vec2 fragUV;
+
+layout (std430, push_constant) uniform PushConstants {
+    mat4 mvp;
+    vec4 octreeData;
+    vec4 octreeMin;
+} pushConstants;
+
+// Octahedral normal, the lower half folded over the diagonals
+vec3 unpackOctahedralNormal(vec2 octahedral) {
+    vec3 normal = vec3(octahedral, 1.0f - abs(octahedral.x) - abs(octahedral.y));
+    float fold = max(-normal.z, 0.0f);
+    normal.x += normal.x >= 0.0f ? -fold : fold;
+    normal.y += normal.y >= 0.0f ? -fold : fold;
+    return normalize(normal);
+}
+
+void main() {
+    float octreeDepth = pushConstants.octreeData.w;
+    vec3 octreeSize = pushConstants.octreeData.xyz;
+    vec3 voxelSize = vec3(
+        octreeSize.x / pow(2, octreeDepth - 1),
+        octreeSize.y / pow(2, octreeDepth - 1),
+        octreeSize.z / pow(2, octreeDepth - 1)
+    );
+    vec3 voxelDimensions = voxelSize / 2.0f;
+
+    // One instance per voxel, centered in its cell of the rendered depth
+    vec4 inPosition = vec4(pushConstants.octreeMin.xyz + (vec3(inCell.xyz) + 0.5f) * voxelSize, 1.0f);
+
+    // Account for Vulkan coordinate system
+    inPosition.y = -inPosition.y;
+
+    // Cube corner of the shared index buffer, x, y and z in bits 0, 1 and 2
+    vec3 corner = vec3(gl_VertexIndex & 1, (gl_VertexIndex >> 1) & 1, (gl_VertexIndex >> 2) & 1) * 2.0f - 1.0f;
+
+    // Same offset as voxel.geom, w included
+    gl_Position = pushConstants.mvp * (inPosition + vec4(corner * voxelDimensions, 1.0f));
+
+    // The normal is packed into w as two snorm8 components
+    fragPosition = gl_Position;
+    fragNormal = unpackOctahedralNormal(unpackSnorm4x8(inCell.w).xy);
+    fragColor = inColor.rgb;
+    fragUV = vec2(0.0f);
+}